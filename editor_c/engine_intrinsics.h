@@ -2,9 +2,32 @@
 
 #include "engine_types.h"
 
+#if defined(_MSC_VER)
 #include <intrin.h>
+#else
+#include <emmintrin.h>
+#include <x86intrin.h>
+#endif
 #include <math.h>
 
+// NOTE(final): Memory barriers for lock-free code, x86 does not reorder stores with stores or loads with loads, so these only stop the compiler.
+//				Loads may still be moved before older stores to other locations, which only the full barrier prevents.
+#if defined(_MSC_VER)
+#define CompletePreviousWritesBeforeFutureWrites() _WriteBarrier()
+#define CompletePreviousReadsBeforeFutureReads() _ReadBarrier()
+#define CompletePreviousMemoryAccesses() _mm_mfence()
+#else
+#define CompletePreviousWritesBeforeFutureWrites() __atomic_thread_fence(__ATOMIC_RELEASE)
+#define CompletePreviousReadsBeforeFutureReads() __atomic_thread_fence(__ATOMIC_ACQUIRE)
+#define CompletePreviousMemoryAccesses() __atomic_thread_fence(__ATOMIC_SEQ_CST)
+#endif
+
+// NOTE(final): Hint for spin-wait loops
+inline void CPUPause(void) {
+	_mm_pause();
+}
+
+#if defined(_MSC_VER)
 inline U32 GetThreadID(void) {
 	U8 *threadLocalStorage = (U8 *)__readgsqword(0x30);
 	U32 threadID = *(U32 *)(threadLocalStorage + 0x48);
@@ -15,6 +38,10 @@ inline U32 AtomicInrementU32(volatile U32 *value) {
 	long result = _InterlockedIncrement((volatile long *)value);
 	return (result);
 }
+inline U32 AtomicDecrementU32(volatile U32 *value) {
+	long result = _InterlockedDecrement((volatile long *)value);
+	return (result);
+}
 
 inline U32 AtomicExchangeU32(volatile U32 *target, U32 value) {
 	U32 result = _InterlockedExchange((volatile long *)target, value);
@@ -42,6 +69,51 @@ inline U64 AtomicCompareExchangeU64(volatile U64 *dest, U64 exchange, U64 compar
 	U64 result = _InterlockedCompareExchange64((__int64 volatile *)dest, exchange, comparand);
 	return (result);
 }
+#else
+// NOTE(final): GCC and Clang builtins, all of them are full barriers like the interlocked functions
+inline U32 AtomicInrementU32(volatile U32 *value) {
+	U32 result = __atomic_add_fetch(value, 1, __ATOMIC_SEQ_CST);
+	return (result);
+}
+inline U32 AtomicDecrementU32(volatile U32 *value) {
+	U32 result = __atomic_sub_fetch(value, 1, __ATOMIC_SEQ_CST);
+	return (result);
+}
+
+inline U32 AtomicExchangeU32(volatile U32 *target, U32 value) {
+	U32 result = __atomic_exchange_n(target, value, __ATOMIC_SEQ_CST);
+	return (result);
+}
+inline U64 AtomicExchangeU64(volatile U64 *target, U64 value) {
+	U64 result = __atomic_exchange_n(target, value, __ATOMIC_SEQ_CST);
+	return (result);
+}
+
+inline U64 AtomicAddU64(volatile U64 *value, U64 addend) {
+	U64 result = __atomic_fetch_add(value, addend, __ATOMIC_SEQ_CST);
+	return (result);
+}
+inline U32 AtomicAddU32(volatile U32 *value, U32 addend) {
+	U32 result = __atomic_fetch_add(value, addend, __ATOMIC_SEQ_CST);
+	return (result);
+}
+
+inline U32 AtomicCompareExchangeU32(volatile U32 *dest, U32 exchange, U32 comparand) {
+	U32 result = __sync_val_compare_and_swap(dest, comparand, exchange);
+	return (result);
+}
+inline U64 AtomicCompareExchangeU64(volatile U64 *dest, U64 exchange, U64 comparand) {
+	U64 result = __sync_val_compare_and_swap(dest, comparand, exchange);
+	return (result);
+}
+
+// NOTE(final): Small ids in the order the threads ask for one, the id is stored per thread on first use
+inline U32 GetThreadID(void) {
+	local_persist volatile U32 threadIDCounter = 0;
+	local_persist thread_local U32 threadID = AtomicInrementU32(&threadIDCounter);
+	return(threadID);
+}
+#endif
 
 inline F32 SquareRoot(F32 value) {
 	F32 result = sqrtf(value);
@@ -0,0 +1,172 @@
+#include "engine_jobs.h"
+#include "engine_intrinsics.h"
+
+// NOTE(final): Index of the worker the calling thread is, the main thread is set to worker zero by the init
+global_variable thread_local U32 globalJobWorkerIndex = JOB_FOREIGN_WORKER_INDEX;
+
+// NOTE(final): Owner only. Returns false when the deque is full.
+internal B32 JobDequePush(JobDeque *deque, const Job &job) {
+	U32 bottom = deque->bottom;
+	U32 top = deque->top;
+	if (bottom - top >= JOB_DEQUE_CAPACITY) {
+		return false;
+	}
+	deque->jobs[bottom & (JOB_DEQUE_CAPACITY - 1)] = job;
+	// NOTE(final): The job must be written before other workers can see it
+	CompletePreviousWritesBeforeFutureWrites();
+	deque->bottom = bottom + 1;
+	return true;
+}
+
+// NOTE(final): Owner only. The bottom is reserved before the top is read, so only the last job can be taken by a thief at the same time.
+internal B32 JobDequePop(JobDeque *deque, Job *outJob) {
+	U32 bottom = deque->bottom - 1;
+	deque->bottom = bottom;
+	CompletePreviousMemoryAccesses();
+	U32 top = deque->top;
+	if ((S32)(bottom - top) < 0) {
+		deque->bottom = top;
+		return false;
+	}
+	*outJob = deque->jobs[bottom & (JOB_DEQUE_CAPACITY - 1)];
+	if (bottom != top) {
+		return true;
+	}
+	// NOTE(final): Last job, whoever increments the top first gets it
+	B32 result = AtomicCompareExchangeU32(&deque->top, top + 1, top) == top;
+	deque->bottom = top + 1;
+	return(result);
+}
+
+// NOTE(final): Any other worker. Returns false when the deque is empty or another worker took the job first.
+internal B32 JobDequeSteal(JobDeque *deque, Job *outJob) {
+	U32 top = deque->top;
+	CompletePreviousMemoryAccesses();
+	U32 bottom = deque->bottom;
+	CompletePreviousReadsBeforeFutureReads();
+	if ((S32)(bottom - top) <= 0) {
+		return false;
+	}
+	*outJob = deque->jobs[top & (JOB_DEQUE_CAPACITY - 1)];
+	B32 result = AtomicCompareExchangeU32(&deque->top, top + 1, top) == top;
+	return(result);
+}
+
+inline void JobInjectionQueueLock(JobInjectionQueue *queue) {
+	while (AtomicCompareExchangeU32(&queue->lock, 1, 0) != 0) {
+		CPUPause();
+	}
+}
+
+inline void JobInjectionQueueUnlock(JobInjectionQueue *queue) {
+	AtomicExchangeU32(&queue->lock, 0);
+}
+
+// NOTE(final): Any thread. Returns false when the queue is full.
+internal B32 JobInjectionQueuePush(JobInjectionQueue *queue, const Job &job) {
+	JobInjectionQueueLock(queue);
+	B32 result = queue->tail - queue->head < JOB_DEQUE_CAPACITY;
+	if (result) {
+		queue->jobs[queue->tail & (JOB_DEQUE_CAPACITY - 1)] = job;
+		queue->tail = queue->tail + 1;
+	}
+	JobInjectionQueueUnlock(queue);
+	return(result);
+}
+
+// NOTE(final): Workers only. The queue is checked without the lock first, so an empty queue costs no lock.
+internal B32 JobInjectionQueuePop(JobInjectionQueue *queue, Job *outJob) {
+	if (queue->head == queue->tail) {
+		return false;
+	}
+	JobInjectionQueueLock(queue);
+	B32 result = queue->head != queue->tail;
+	if (result) {
+		*outJob = queue->jobs[queue->head & (JOB_DEQUE_CAPACITY - 1)];
+		queue->head = queue->head + 1;
+	}
+	JobInjectionQueueUnlock(queue);
+	return(result);
+}
+
+internal void JobRun(const Job &job, U32 workerIndex) {
+	job.callback(job.data, workerIndex);
+	// NOTE(final): The parent is read before the decrement, because the waiting worker may release the counter as soon as it is zero
+	JobCounter *counter = job.counter;
+	while (counter) {
+		JobCounter *parent = counter->parent;
+		AtomicDecrementU32(&counter->pendingCount);
+		counter = parent;
+	}
+}
+
+// NOTE(final): Runs a job of the own deque first, then a job of the foreign threads, otherwise steals one from the other workers starting with the next one.
+//				Returns false when there was no job to run.
+internal B32 JobSystemRunNext(JobSystem *jobSystem, U32 workerIndex) {
+	Assert(workerIndex < jobSystem->workerCount);
+	Job job;
+	if (JobDequePop(jobSystem->deques + workerIndex, &job) || JobInjectionQueuePop(&jobSystem->injectionQueue, &job)) {
+		JobRun(job, workerIndex);
+		return true;
+	}
+	for (U32 offset = 1; offset < jobSystem->workerCount; ++offset) {
+		U32 victimIndex = (workerIndex + offset) % jobSystem->workerCount;
+		if (JobDequeSteal(jobSystem->deques + victimIndex, &job)) {
+			JobRun(job, workerIndex);
+			return true;
+		}
+	}
+	return false;
+}
+
+external void JobSystemInit(JobSystem *jobSystem, U32 threadCount) {
+	Assert(threadCount < JOB_MAX_WORKER_COUNT);
+	*jobSystem = {};
+	jobSystem->workerCount = threadCount + 1;
+	globalJobWorkerIndex = 0;
+	PlatformJobThreadsCreate(jobSystem, threadCount);
+}
+
+external void JobSystemWorkerRun(JobSystem *jobSystem, U32 workerIndex) {
+	Assert(workerIndex > 0 && workerIndex < jobSystem->workerCount);
+	globalJobWorkerIndex = workerIndex;
+	for (;;) {
+		if (!JobSystemRunNext(jobSystem, workerIndex)) {
+			PlatformJobThreadSleep(jobSystem);
+		}
+	}
+}
+
+external PLATFORM_ADD_JOB(JobSystemAddJob) {
+	Job job = {};
+	job.callback = callback;
+	job.data = data;
+	job.counter = counter;
+	for (JobCounter *parent = counter; parent; parent = parent->parent) {
+		AtomicInrementU32(&parent->pendingCount);
+	}
+	U32 workerIndex = globalJobWorkerIndex;
+	if (workerIndex == JOB_FOREIGN_WORKER_INDEX) {
+		while (!JobInjectionQueuePush(&jobSystem->injectionQueue, job)) {
+			CPUPause();
+		}
+		PlatformJobThreadsWake(jobSystem, 1);
+		return;
+	}
+	if (JobDequePush(jobSystem->deques + workerIndex, job)) {
+		PlatformJobThreadsWake(jobSystem, 1);
+	} else {
+		JobRun(job, workerIndex);
+	}
+}
+
+external PLATFORM_WAIT_FOR_JOBS(JobSystemWaitForJobs) {
+	U32 workerIndex = globalJobWorkerIndex;
+	while (counter->pendingCount > 0) {
+		if (workerIndex == JOB_FOREIGN_WORKER_INDEX || !JobSystemRunNext(jobSystem, workerIndex)) {
+			CPUPause();
+		}
+	}
+	// NOTE(final): Everything the jobs have written must be visible to the waiting worker
+	CompletePreviousReadsBeforeFutureReads();
+}
\ No newline at end of file
@@ -0,0 +1,87 @@
+#pragma once
+
+#include "engine_types.h"
+
+// NOTE(final): Worker zero is the main thread which has called the job system init, the job threads use the worker indices after it
+#define JOB_CALLBACK(name) void name(void *data, U32 workerIndex)
+typedef JOB_CALLBACK(job_callback);
+
+// NOTE(final): Must be a power of two
+constant U32 JOB_DEQUE_CAPACITY = 256;
+constant U32 JOB_MAX_WORKER_COUNT = 16;
+// NOTE(final): Worker index of every thread which is neither the main thread nor a job thread, like an audio or a loader thread
+constant U32 JOB_FOREIGN_WORKER_INDEX = 0xFFFFFFFF;
+
+// NOTE(final): Number of jobs which are not done yet. Adding a job to a counter adds it to all parent counters as well,
+//				so waiting for a parent waits for all jobs of its child counters, even when they are added by a running job.
+struct JobCounter {
+	volatile U32 pendingCount;
+	JobCounter *parent;
+};
+
+struct Job {
+	job_callback *callback;
+	void *data;
+	JobCounter *counter;
+};
+
+// NOTE(final): Chase-Lev work-stealing deque, only the owning worker pushes and pops at the bottom, every other worker steals from the top.
+//				The indices are never wrapped, the job index is masked instead. Top and bottom are kept on separate cache lines.
+struct JobDeque {
+	Job jobs[JOB_DEQUE_CAPACITY];
+	volatile U32 top;
+	U8 topPadding[60];
+	volatile U32 bottom;
+	U8 bottomPadding[60];
+};
+
+// NOTE(final): Jobs added by foreign threads, which must never touch a deque because they are not its owner.
+//				Head and tail are changed under the spin lock only, the workers take jobs from it before stealing.
+struct JobInjectionQueue {
+	Job jobs[JOB_DEQUE_CAPACITY];
+	volatile U32 head;
+	volatile U32 tail;
+	volatile U32 lock;
+};
+
+struct JobSystem {
+	JobDeque deques[JOB_MAX_WORKER_COUNT];
+	JobInjectionQueue injectionQueue;
+	// NOTE(final): Number of job threads plus the main thread
+	U32 workerCount;
+	// NOTE(final): Platform semaphore the idle job threads sleep on
+	void *semaphore;
+};
+
+// NOTE(final): Adds a job to the deque of the calling worker. The counter is optional, when the deque is full the job is run right away.
+//				Foreign threads add the job to the injection queue instead and wait while it is full, they never run a job themselves.
+#define PLATFORM_ADD_JOB(name) void name(JobSystem *jobSystem, job_callback *callback, void *data, JobCounter *counter)
+typedef PLATFORM_ADD_JOB(platform_add_job);
+// NOTE(final): The calling worker runs or steals other jobs until the counter is zero.
+//				Foreign threads only wait, because the jobs expect the index of a worker which owns its per-worker data.
+#define PLATFORM_WAIT_FOR_JOBS(name) void name(JobSystem *jobSystem, JobCounter *counter)
+typedef PLATFORM_WAIT_FOR_JOBS(platform_wait_for_jobs);
+
+// NOTE(final): Job system and its functions, as it is passed from the platform layer to the game
+struct PlatformJobs {
+	JobSystem *jobSystem;
+	platform_add_job *PlatformAddJob;
+	platform_wait_for_jobs *PlatformWaitForJobs;
+};
+
+inline JobCounter JobCounterCreate(JobCounter *parent = 0) {
+	JobCounter result = {};
+	result.parent = parent;
+	return(result);
+}
+
+external void JobSystemInit(JobSystem *jobSystem, U32 threadCount);
+// NOTE(final): Entry point of every job thread, never returns
+external void JobSystemWorkerRun(JobSystem *jobSystem, U32 workerIndex);
+external PLATFORM_ADD_JOB(JobSystemAddJob);
+external PLATFORM_WAIT_FOR_JOBS(JobSystemWaitForJobs);
+
+// NOTE(final): Implemented by the platform layer
+external void PlatformJobThreadsCreate(JobSystem *jobSystem, U32 threadCount);
+external void PlatformJobThreadSleep(JobSystem *jobSystem);
+external void PlatformJobThreadsWake(JobSystem *jobSystem, U32 count);
\ No newline at end of file
@@ -8,6 +8,7 @@ constant F32 TAU32 = 6.28318530717958647692f;
 constant F32 DEG2RAD32 = PI32 / 180.0f;
 constant F32 RAD2DEG32 = 180.0f / PI32;
 constant F32 FLOAT_TOLERANCE = 0.00001f;
+constant F32 FLOAT_MAX = 3.402823466e+38f;
 
 #define Min(a, b) ((a) < (b) ? (a) : (b))
 #define Max(a, b) ((a) > (b) ? (a) : (b))
@@ -504,6 +505,14 @@ inline Transform TransformIdentity() {
 	return(result);
 }
 
+inline B32 TransformIsIdentity(const Transform &transform) {
+	B32 result = Vec2Equals(transform.pos, V2()) &&
+		Vec2Equals(transform.rot.col1, V2(1.0f, 0.0f)) &&
+		Vec2Equals(transform.rot.col2, V2(0.0f, 1.0f)) &&
+		Vec2Equals(transform.scale, V2(1.0f, 1.0f));
+	return(result);
+}
+
 inline Transform TransformMakeTranslation(const Vec2f &translation) {
 	Transform result;
 	result.pos = translation;
@@ -556,4 +565,19 @@ inline AABB AABBCombine(const AABB &a, const AABB &b) {
 	result.min = Vec2Min(a.min, b.min);
 	result.max = Vec2Max(a.max, b.max);
 	return(result);
+}
+
+inline B32 AABBOverlap(const AABB &a, const AABB &b) {
+	B32 result = !(a.max.x < b.min.x || a.min.x > b.max.x || a.max.y < b.min.y || a.min.y > b.max.y);
+	return(result);
+}
+
+inline B32 AABBContains(const AABB &outer, const AABB &inner) {
+	B32 result = outer.min.x <= inner.min.x && outer.min.y <= inner.min.y && outer.max.x >= inner.max.x && outer.max.y >= inner.max.y;
+	return(result);
+}
+
+inline F32 AABBPerimeter(const AABB &a) {
+	F32 result = 2.0f * ((a.max.x - a.min.x) + (a.max.y - a.min.y));
+	return(result);
 }
\ No newline at end of file
@@ -34,7 +34,7 @@ inline void ZeroSize(void *base, memory_size size) {
 #define ZeroStruct(instance) \
 	ZeroSize(&(instance), sizeof(instance))
 #define ZeroArray(ptr, count) \
-	ZeroSize(ptr, count*sizeof((ptr)[0]))
+	ZeroSize(ptr, (count)*sizeof((ptr)[0]))
 
 inline MemoryBlock MemoryBlockCreate(void *base, memory_size size, MemoryFlag flags = MemoryFlagsDefault()) {
 	Assert(base);
@@ -86,4 +86,4 @@ inline void TemporaryMemoryEnd(TemporaryMemory *tempMemory) {
 #define PushStruct(block, type, ...) \
 	(type *)__PushSize(block, sizeof(type), ## __VA_ARGS__)
 #define PushArray(block, type, count, ...) \
-	(type *)__PushSize(block, sizeof(type) * count, ## __VA_ARGS__)
+	(type *)__PushSize(block, sizeof(type) * (count), ## __VA_ARGS__)
@@ -1,17 +1,11 @@
 #include "engine_physics.h"
 
+#include <emmintrin.h>
+
 constant F32 PHYSICS_EPSILON = 0.00000001f;
 
 // https://jsfiddle.net/g9v86af8/8/
 
-inline void PhysicsBodiesRefresh(Physics *physics) {
-	U32 bodyCount = 0;
-	for (Body *body = (Body *)physics->usedBodies.next; body != (Body *)&physics->usedBodies; body = (Body *)body->next) {
-		physics->bodies[bodyCount++] = body;
-	}
-	physics->bodyCount = bodyCount;
-}
-
 global_variable Vec2f globalPhysicsEdgeNormals[4] = {
 	V2(0, -1), 
 	V2(-1, 0),
@@ -19,10 +13,8 @@ global_variable Vec2f globalPhysicsEdgeNormals[4] = {
 	V2(1, 0),
 };
 
-internal void PhysicsCreateContacts(Physics *physics, Body *bodyA, Body *bodyB) {
-	// Simple SAT-Test to calculate the normal and distance
-	Vec2f relPos = bodyB->position - bodyA->position;
-	Vec2f bothRadius = bodyA->radius + bodyB->radius;
+// NOTE(final): Simple SAT-Test to calculate the face on A and the overlap between two boxes
+inline F32 PhysicsBoxOverlap(const Vec2f &relPos, const Vec2f &bothRadius, S32 *outFaceIndex) {
 	F32 xOverlap = bothRadius.x - Abs(relPos.x);
 	F32 yOverlap = bothRadius.y - Abs(relPos.y);
 	S32 faceIndex = 0;
@@ -44,172 +36,1552 @@ internal void PhysicsCreateContacts(Physics *physics, Body *bodyA, Body *bodyB)
 		}
 		separation = yOverlap;
 	}
+	*outFaceIndex = faceIndex;
+	return(separation);
+}
+
+inline U32 PhysicsBoxFeatureMake(S32 faceIndex) {
+	// NOTE(final): Boxes have a single contact on the face of A, so there is no clip feature
+	U32 result = (U32)(faceIndex + 1) * PHYSICS_CONTACT_FEATURE_FACEA_PRIME + 1 * PHYSICS_CONTACT_FEATURE_FACEB_PRIME;
+	return(result);
+}
+
+// NOTE(final): Compare exchange on the contact memory cursor, so workers can push chunks at the same time without locking.
+//				The cursor is its own U64, because the used size of the memory block is a memory_size and only 4 bytes wide on 32-bit.
+//				The cursor never grows beyond the block size, so a failed push does not break the following pushes.
+internal PhysicsContactChunk *PhysicsContactChunkPush(Physics *physics) {
+	MemoryBlock *memory = &physics->contactMemory;
+	volatile U64 *used = &physics->contactMemoryUsed;
+	for (;;) {
+		U64 oldUsed = *used;
+		U64 newUsed = oldUsed + sizeof(PhysicsContactChunk);
+		if (newUsed > memory->size) {
+			return(0);
+		}
+		if (AtomicCompareExchangeU64(used, newUsed, oldUsed) == oldUsed) {
+			PhysicsContactChunk *result = (PhysicsContactChunk *)((U8 *)memory->base + oldUsed);
+			result->count = 0;
+			result->next = 0;
+			return(result);
+		}
+	}
+}
+
+// NOTE(final): Returns room for the given number of contacts in the last chunk of the buffer, or null when the contact memory is used up
+internal Contact *PhysicsContactBufferReserve(Physics *physics, PhysicsContactBuffer *buffer, U32 count) {
+	Assert(count <= PHYSICS_CONTACT_CHUNK_CAPACITY);
+	PhysicsContactChunk *chunk = buffer->lastChunk;
+	if (!chunk || chunk->count + count > PHYSICS_CONTACT_CHUNK_CAPACITY) {
+		chunk = PhysicsContactChunkPush(physics);
+		if (!chunk) {
+			return(0);
+		}
+		if (buffer->lastChunk) {
+			buffer->lastChunk->next = chunk;
+		} else {
+			buffer->firstChunk = chunk;
+		}
+		buffer->lastChunk = chunk;
+	}
+	Contact *result = chunk->contacts + chunk->count;
+	return(result);
+}
+
+inline void PhysicsContactBufferCommit(PhysicsContactBuffer *buffer, U32 count) {
+	buffer->lastChunk->count += count;
+	buffer->contactCount += count;
+}
+
+inline void PhysicsContactAdd(Physics *physics, PhysicsContactBuffer *buffer, Body *bodyA, Body *bodyB, const Vec2f &normal, F32 distance, U64 key, U32 feature) {
+	Contact *contact = PhysicsContactBufferReserve(physics, buffer, 1);
+	if (!contact) {
+		++buffer->overflowCount;
+		return;
+	}
+	*contact = {};
+	contact->distance = distance;
+	contact->normal = normal;
+	contact->bodyA = bodyA;
+	contact->bodyB = bodyB;
+	contact->key = key;
+	contact->feature = feature;
+	PhysicsContactBufferCommit(buffer, 1);
+}
+
+inline U32 PhysicsContactHash(U64 key, U32 feature, U32 hashMask) {
+	U32 result = (U32)(((key ^ ((U64)feature << 40)) * 0x9E3779B97F4A7C15ULL) >> 32) & hashMask;
+	return(result);
+}
+
+// NOTE(final): Swaps the step memory and hashes the contacts of the last step, before new contacts are created.
+//				The step memory of the last step is kept, because it holds the previous contacts.
+internal void PhysicsContactsSwap(Physics *physics) {
+	physics->prevContacts = physics->contacts;
+	physics->prevContactCount = physics->contactCount;
+	physics->contacts = 0;
+	physics->contactCount = 0;
+
+	physics->stepIndex = !physics->stepIndex;
+	MemoryBlock *stepMemory = PhysicsStepMemoryGet(physics);
+	stepMemory->used = 0;
+
+	// NOTE(final): Must be a power of two, with at least twice as many entries as contacts
+	U32 hashCount = 16;
+	while (hashCount < 2 * physics->prevContactCount) {
+		hashCount <<= 1;
+	}
+	physics->contactHashMask = hashCount - 1;
+	physics->contactHashTable = PushArray(stepMemory, U32, hashCount, MemoryFlag::MemoryFlag_None);
+	for (U32 hashIndex = 0; hashIndex < hashCount; ++hashIndex) {
+		physics->contactHashTable[hashIndex] = PHYSICS_CONTACT_NULL;
+	}
+	physics->contactHashNext = 0;
+	if (physics->prevContactCount > 0) {
+		physics->contactHashNext = PushArray(stepMemory, U32, physics->prevContactCount, MemoryFlag::MemoryFlag_None);
+	}
+	for (U32 contactIndex = 0; contactIndex < physics->prevContactCount; ++contactIndex) {
+		Contact *contact = physics->prevContacts + contactIndex;
+		U32 hash = PhysicsContactHash(contact->key, contact->feature, physics->contactHashMask);
+		physics->contactHashNext[contactIndex] = physics->contactHashTable[hash];
+		physics->contactHashTable[hash] = contactIndex;
+	}
+
+	physics->contactMemoryUsed = 0;
+	physics->contactRanges = 0;
+	physics->contactRangeCount = 0;
+	for (U32 bufferIndex = 0; bufferIndex < PHYSICS_MAX_WORKER_COUNT; ++bufferIndex) {
+		physics->contactBuffers[bufferIndex] = {};
+	}
+}
+
+// NOTE(final): Upper bound of the step memory used per contact: The contact, its island and solver indices and a quarter of a solver batch.
+//				Each color may have one batch which is not full, these batches are reserved up front.
+constant memory_size PHYSICS_STEP_CONTACT_SIZE = sizeof(Contact) + 4 * sizeof(U32) + (sizeof(PhysicsSolverBatch) + PHYSICS_SOLVER_LANE_COUNT - 1) / PHYSICS_SOLVER_LANE_COUNT;
+constant memory_size PHYSICS_STEP_RESERVED_SIZE = PHYSICS_SOLVER_MAX_COLOR_COUNT * sizeof(PhysicsSolverBatch);
+
+inline void PhysicsContactRangeBegin(PhysicsContactRange *range, PhysicsContactBuffer *buffer) {
+	range->buffer = buffer;
+	range->chunk = buffer->lastChunk;
+	range->chunkIndex = buffer->lastChunk ? buffer->lastChunk->count : 0;
+	range->contactCount = buffer->contactCount;
+}
+
+inline void PhysicsContactRangeEnd(PhysicsContactRange *range) {
+	range->contactCount = range->buffer->contactCount - range->contactCount;
+}
+
+// NOTE(final): Copies the given number of contacts of a job range, chunks may not be full so the copy steps over to the next chunk by the chunk count
+internal void PhysicsContactRangeCopy(const PhysicsContactRange *range, Contact *contacts, U32 contactCount) {
+	const PhysicsContactChunk *chunk = range->chunk ? range->chunk : range->buffer->firstChunk;
+	U32 chunkIndex = range->chunk ? range->chunkIndex : 0;
+	U32 contactIndex = 0;
+	while (contactIndex < contactCount) {
+		Assert(chunk);
+		if (chunkIndex == chunk->count) {
+			chunk = chunk->next;
+			chunkIndex = 0;
+			continue;
+		}
+		contacts[contactIndex++] = chunk->contacts[chunkIndex++];
+	}
+}
+
+// NOTE(final): Merges the contact ranges into the contacts in job order, so the contact order is the order of the candidate pairs and does not depend on the number or the timing of the workers.
+//				Every range is copied into its own part of the contacts, so the copies do not need any locking.
+//				Contacts which do not fit into the step memory are dropped and counted as overflow.
+internal void PhysicsContactsMerge(Physics *physics) {
+	U32 overflowCount = 0;
+	U32 tileBoxesTested = 0;
+	for (U32 bufferIndex = 0; bufferIndex < PHYSICS_MAX_WORKER_COUNT; ++bufferIndex) {
+		PhysicsContactBuffer *buffer = physics->contactBuffers + bufferIndex;
+		overflowCount += buffer->overflowCount;
+		tileBoxesTested += buffer->tileBoxesTested;
+	}
+	U32 totalCount = 0;
+	for (U32 rangeIndex = 0; rangeIndex < physics->contactRangeCount; ++rangeIndex) {
+		totalCount += physics->contactRanges[rangeIndex].contactCount;
+	}
+
+	MemoryBlock *stepMemory = PhysicsStepMemoryGet(physics);
+	memory_size freeSize = stepMemory->size - stepMemory->used;
+	U32 capacity = freeSize > PHYSICS_STEP_RESERVED_SIZE ? (U32)((freeSize - PHYSICS_STEP_RESERVED_SIZE) / PHYSICS_STEP_CONTACT_SIZE) : 0;
+	U32 contactCount = Min(totalCount, capacity);
+	overflowCount += totalCount - contactCount;
+
+	if (contactCount > 0) {
+		physics->contacts = PushArray(stepMemory, Contact, contactCount, MemoryFlag::MemoryFlag_None);
+		U32 contactStart = 0;
+		for (U32 rangeIndex = 0; rangeIndex < physics->contactRangeCount && contactStart < contactCount; ++rangeIndex) {
+			const PhysicsContactRange *range = physics->contactRanges + rangeIndex;
+			U32 copyCount = Min(range->contactCount, contactCount - contactStart);
+			PhysicsContactRangeCopy(range, physics->contacts + contactStart, copyCount);
+			contactStart += copyCount;
+		}
+	}
+	physics->contactCount = contactCount;
+	physics->stats.contactOverflowCount = overflowCount;
+	physics->stats.contactChunkCount = (U32)(physics->contactMemoryUsed / sizeof(PhysicsContactChunk));
+	physics->stats.tileBoxesTested = tileBoxesTested;
+}
+
+// NOTE(final): Carries the accumulated impulses of matching contacts from the last step over
+internal void PhysicsContactsWarmStart(Physics *physics) {
+	for (U32 contactIndex = 0; contactIndex < physics->contactCount; ++contactIndex) {
+		Contact *contact = physics->contacts + contactIndex;
+		U32 hash = PhysicsContactHash(contact->key, contact->feature, physics->contactHashMask);
+		for (U32 prevIndex = physics->contactHashTable[hash]; prevIndex != PHYSICS_CONTACT_NULL; prevIndex = physics->contactHashNext[prevIndex]) {
+			Contact *prevContact = physics->prevContacts + prevIndex;
+			if (prevContact->key == contact->key && prevContact->feature == contact->feature) {
+				contact->normalImpulse = prevContact->normalImpulse;
+				contact->tangentImpulse = prevContact->tangentImpulse;
+				++physics->stats.warmStartCount;
+				break;
+			}
+		}
+		if (contact->normalImpulse != 0) {
+			Vec2f *velocities = physics->bodyData.velocities;
+			velocities[contact->bodyA->index] += contact->normal * contact->normalImpulse * contact->invMassA;
+			velocities[contact->bodyB->index] -= contact->normal * contact->normalImpulse * contact->invMassB;
+		}
+	}
+}
+
+inline __m128 PhysicsSelect(__m128 mask, __m128 a, __m128 b) {
+	__m128 result = _mm_or_ps(_mm_and_ps(mask, a), _mm_andnot_ps(mask, b));
+	return(result);
+}
+
+// NOTE(final): Box vs box contacts for four candidate pairs at once, all bodies are axis aligned boxes.
+//				Pairs outside any of the face regions are edge contacts, which are skipped to fix ghost collisions.
+internal void PhysicsCreateContactsBatch(Physics *physics, PhysicsContactBuffer *buffer, const PhysicsPair *pairs, U32 pairCount) {
+	const PhysicsBodyData *bodyData = &physics->bodyData;
+	const __m128 zero = _mm_setzero_ps();
+	const __m128 one = _mm_set1_ps(1.0f);
+	const __m128 two = _mm_set1_ps(2.0f);
+	const __m128 minusOne = _mm_set1_ps(-1.0f);
+	const __m128 epsilon = _mm_set1_ps(PHYSICS_EPSILON);
+	const __m128 signMask = _mm_set1_ps(-0.0f);
+
+	Body *bodiesA[4], *bodiesB[4];
+	F32 posAX[4], posAY[4], posBX[4], posBY[4];
+	F32 radiusAX[4], radiusAY[4], radiusBX[4], radiusBY[4];
+	F32 normalsX[4], normalsY[4], separations[4], faces[4];
+	for (U32 pairIndex = 0; pairIndex < pairCount; pairIndex += 4) {
+		U32 laneCount = Min(4, pairCount - pairIndex);
+
+		// NOTE(final): Unused lanes repeat the first pair, so there are no divisions by zero
+		for (U32 lane = 0; lane < 4; ++lane) {
+			const PhysicsPair *pair = pairs + pairIndex + (lane < laneCount ? lane : 0);
+			Body *bodyA = pair->bodyA;
+			Body *bodyB = pair->bodyB;
+			// NOTE(final): Broadphases may report a pair in any order, but the face feature depends on it
+			if (bodyA->bodyId > bodyB->bodyId) {
+				Body *temp = bodyA;
+				bodyA = bodyB;
+				bodyB = temp;
+			}
+			bodiesA[lane] = bodyA;
+			bodiesB[lane] = bodyB;
+			posAX[lane] = bodyData->positions[bodyA->index].x;
+			posAY[lane] = bodyData->positions[bodyA->index].y;
+			posBX[lane] = bodyData->positions[bodyB->index].x;
+			posBY[lane] = bodyData->positions[bodyB->index].y;
+			radiusAX[lane] = bodyData->radii[bodyA->index].x;
+			radiusAY[lane] = bodyData->radii[bodyA->index].y;
+			radiusBX[lane] = bodyData->radii[bodyB->index].x;
+			radiusBY[lane] = bodyData->radii[bodyB->index].y;
+		}
+
+		__m128 rAX = _mm_loadu_ps(radiusAX);
+		__m128 rAY = _mm_loadu_ps(radiusAY);
+		__m128 rBX = _mm_loadu_ps(radiusBX);
+		__m128 rBY = _mm_loadu_ps(radiusBY);
+		__m128 relX = _mm_sub_ps(_mm_loadu_ps(posBX), _mm_loadu_ps(posAX));
+		__m128 relY = _mm_sub_ps(_mm_loadu_ps(posBY), _mm_loadu_ps(posAY));
+
+		// SAT on both axis, the axis with the smaller overlap is the face on A
+		__m128 overlapX = _mm_sub_ps(_mm_add_ps(rAX, rBX), _mm_andnot_ps(signMask, relX));
+		__m128 overlapY = _mm_sub_ps(_mm_add_ps(rAY, rBY), _mm_andnot_ps(signMask, relY));
+		__m128 useX = _mm_cmplt_ps(overlapX, overlapY);
+		__m128 separation = PhysicsSelect(useX, overlapX, overlapY);
+		__m128 signX = PhysicsSelect(_mm_cmplt_ps(relX, zero), minusOne, one);
+		__m128 signY = PhysicsSelect(_mm_cmplt_ps(relY, zero), minusOne, one);
+		__m128 normalX = _mm_and_ps(useX, signX);
+		__m128 normalY = _mm_andnot_ps(useX, signY);
+		// NOTE(final): Same face index as the edge normals: Bottom = 0, Left = 1, Top = 2, Right = 3
+		__m128 face = PhysicsSelect(useX, _mm_add_ps(two, signX), _mm_add_ps(one, signY));
+
+		// NOTE(final): The tangent is the cross of the normal and always axis aligned, so everything is done on the tangent axis only.
+		//				The normal components of the segments cancel out exactly, so this gives the same results as the full vector math.
+		__m128 tangentSign = PhysicsSelect(useX, _mm_sub_ps(zero, signX), signY);
+		__m128 relT = PhysicsSelect(useX, relY, relX);
+		__m128 radiusAT = PhysicsSelect(useX, rAY, rAX);
+		__m128 radiusBT = PhysicsSelect(useX, rBY, rBX);
+		__m128 posAT = PhysicsSelect(useX, _mm_loadu_ps(posAY), _mm_loadu_ps(posAX));
+		__m128 posBT = PhysicsSelect(useX, _mm_loadu_ps(posBY), _mm_loadu_ps(posBX));
+		__m128 bothRadiusT = _mm_add_ps(radiusAT, radiusBT);
+
+		// Build minkowski segment based on A extended and get the region of the origin on it
+		__m128 segmentMinkowski1 = _mm_sub_ps(relT, _mm_mul_ps(tangentSign, bothRadiusT));
+		__m128 segmentMinkowski2 = _mm_add_ps(relT, _mm_mul_ps(tangentSign, bothRadiusT));
+		__m128 segmentMinkowskiAB = _mm_sub_ps(segmentMinkowski2, segmentMinkowski1);
+		__m128 distanceToOrigin = _mm_sub_ps(zero, segmentMinkowski1);
+		__m128 regionA = _mm_div_ps(_mm_mul_ps(segmentMinkowskiAB, distanceToOrigin), _mm_mul_ps(segmentMinkowskiAB, segmentMinkowskiAB));
+		__m128 percentageA = _mm_min_ps(_mm_max_ps(regionA, zero), one);
+
+		// Closest point on the face of A and its region on the face of B
+		__m128 segmentA1 = _mm_add_ps(posAT, _mm_mul_ps(tangentSign, radiusAT));
+		__m128 segmentA2 = _mm_add_ps(posAT, _mm_mul_ps(_mm_sub_ps(zero, tangentSign), radiusAT));
+		__m128 closestOnA = _mm_add_ps(segmentA1, _mm_mul_ps(_mm_sub_ps(segmentA2, segmentA1), percentageA));
+		__m128 segmentB1 = _mm_add_ps(posBT, _mm_mul_ps(_mm_sub_ps(zero, tangentSign), radiusBT));
+		__m128 segmentB2 = _mm_add_ps(posBT, _mm_mul_ps(tangentSign, radiusBT));
+		__m128 segmentBAB = _mm_sub_ps(segmentB2, segmentB1);
+		__m128 distanceToClosest = _mm_sub_ps(closestOnA, segmentB1);
+		__m128 regionB = _mm_div_ps(_mm_mul_ps(segmentBAB, distanceToClosest), _mm_mul_ps(segmentBAB, segmentBAB));
+
+		// NOTE(final): One minus epsilon rounds to one in F32, so the upper bound is inclusive
+		__m128 skipA = _mm_or_ps(_mm_cmplt_ps(regionA, epsilon), _mm_cmpge_ps(regionA, one));
+		__m128 skipB = _mm_or_ps(_mm_cmplt_ps(regionB, epsilon), _mm_cmpge_ps(regionB, one));
+		S32 skipMask = _mm_movemask_ps(_mm_or_ps(skipA, skipB));
+
+		_mm_storeu_ps(normalsX, normalX);
+		_mm_storeu_ps(normalsY, normalY);
+		_mm_storeu_ps(separations, separation);
+		_mm_storeu_ps(faces, face);
+
+		// Compact the face contacts into the contact buffer
+		for (U32 lane = 0; lane < laneCount; ++lane) {
+			if (!(skipMask & (1 << lane))) {
+				Body *bodyA = bodiesA[lane];
+				Body *bodyB = bodiesB[lane];
+				S32 faceIndex = (S32)faces[lane];
+				PhysicsContactAdd(physics, buffer, bodyA, bodyB, V2(normalsX[lane], normalsY[lane]), -separations[lane], PhysicsPairKeyMake(bodyA->bodyId, bodyB->bodyId), PhysicsBoxFeatureMake(faceIndex));
+			}
+		}
+	}
+}
+
+constant U32 PHYSICS_SHAPE_PAIR_COUNT = ShapeKind::ShapeKind_Count * ShapeKind::ShapeKind_Count;
+constant U32 PHYSICS_BOX_SHAPE_PAIR = ShapeKind::ShapeKind_Box * ShapeKind::ShapeKind_Count + ShapeKind::ShapeKind_Box;
+
+// NOTE(final): Generators are defined for ordered shape kinds only, the body ids order pairs of the same shape kind so the features are stable
+inline PhysicsPair PhysicsPairOrder(const PhysicsPair &pair) {
+	PhysicsPair result = pair;
+	ShapeKind kindA = pair.bodyA->shape.kind;
+	ShapeKind kindB = pair.bodyB->shape.kind;
+	if (kindA > kindB || (kindA == kindB && pair.bodyA->bodyId > pair.bodyB->bodyId)) {
+		result.bodyA = pair.bodyB;
+		result.bodyB = pair.bodyA;
+	}
+	return(result);
+}
+
+inline U32 PhysicsShapePairIndex(const PhysicsPair &orderedPair) {
+	U32 result = orderedPair.bodyA->shape.kind * ShapeKind::ShapeKind_Count + orderedPair.bodyB->shape.kind;
+	return(result);
+}
+
+// NOTE(final): Runs a single generator over all pairs of the same shape pair
+internal void PhysicsCreateContactsGenerated(Physics *physics, PhysicsContactBuffer *buffer, const PhysicsPair *pairs, U32 pairCount, generate_contacts *generator) {
+	const Vec2f *positions = physics->bodyData.positions;
+	for (U32 pairIndex = 0; pairIndex < pairCount; ++pairIndex) {
+		Body *bodyA = pairs[pairIndex].bodyA;
+		Body *bodyB = pairs[pairIndex].bodyB;
+		Transform transformA = TransformMult(bodyA->shape.localTransform, TransformMakeTranslation(positions[bodyA->index]));
+		Transform transformB = TransformMult(bodyB->shape.localTransform, TransformMakeTranslation(positions[bodyB->index]));
+		// NOTE(final): Without room in the buffer the contacts are still generated, so the number of dropped contacts is known
+		Contact overflowContacts[PHYSICS_MAX_GENERATOR_CONTACT_COUNT];
+		Contact *contacts = PhysicsContactBufferReserve(physics, buffer, PHYSICS_MAX_GENERATOR_CONTACT_COUNT);
+		U32 contactCount = generator(physics, transformA, transformB, &bodyA->shape, &bodyB->shape, 0, contacts ? contacts : overflowContacts);
+		Assert(contactCount <= PHYSICS_MAX_GENERATOR_CONTACT_COUNT);
+		if (!contacts) {
+			buffer->overflowCount += contactCount;
+			continue;
+		}
+		U64 key = PhysicsPairKeyMake(bodyA->bodyId, bodyB->bodyId);
+		for (U32 contactIndex = 0; contactIndex < contactCount; ++contactIndex) {
+			Contact *contact = contacts + contactIndex;
+			contact->bodyA = bodyA;
+			contact->bodyB = bodyB;
+			contact->key = key;
+		}
+		if (contactCount > 0) {
+			PhysicsContactBufferCommit(buffer, contactCount);
+		}
+	}
+}
 
-	Vec2f normal = globalPhysicsEdgeNormals[faceIndex];
-	Vec2f invNormal = normal * -1;
-	Vec2f tangent = Vec2Cross(normal, 1.0f);
-	Vec2f invTangent = tangent * -1;
+// NOTE(final): Candidate pairs are sorted into buckets by their shape pair, so every generator runs once over a homogeneous batch.
+//				Box pairs are the common case and use the batched box contacts, which skips the sorting when all pairs are boxes.
+//				This runs on a single job of candidate pairs, so the pairs are sorted on the stack of the worker.
+internal void PhysicsCreateContacts(Physics *physics, PhysicsContactBuffer *buffer, const PhysicsPair *pairs, U32 pairCount) {
+	Assert(pairCount <= PHYSICS_PAIR_JOB_COUNT);
+	if (pairCount == 0) {
+		return;
+	}
+	PhysicsPair orderedPairs[PHYSICS_PAIR_JOB_COUNT];
+	U8 pairBuckets[PHYSICS_PAIR_JOB_COUNT];
+	U32 bucketStarts[PHYSICS_SHAPE_PAIR_COUNT + 1] = {};
+	for (U32 pairIndex = 0; pairIndex < pairCount; ++pairIndex) {
+		orderedPairs[pairIndex] = PhysicsPairOrder(pairs[pairIndex]);
+		U32 bucketIndex = PhysicsShapePairIndex(orderedPairs[pairIndex]);
+		pairBuckets[pairIndex] = (U8)bucketIndex;
+		++bucketStarts[bucketIndex + 1];
+	}
 
-	// Build minkowski segment based on A extended
-	Vec2f origin = V2(0, 0);
-	Vec2f segmentMinkowski1 = V2(relPos.x + normal.x * bothRadius.x - tangent.x * bothRadius.x, relPos.y + normal.y * bothRadius.y - tangent.y * bothRadius.y);
-	Vec2f segmentMinkowski2 = V2(relPos.x + normal.x * bothRadius.x + tangent.x * bothRadius.x, relPos.y + normal.y * bothRadius.y + tangent.y * bothRadius.y);
-	Vec2f segmentMinkowskiAB = segmentMinkowski2 - segmentMinkowski1;
+	if (bucketStarts[PHYSICS_BOX_SHAPE_PAIR + 1] == pairCount) {
+		PhysicsCreateContactsBatch(physics, buffer, orderedPairs, pairCount);
+	} else {
+		for (U32 bucketIndex = 0; bucketIndex < PHYSICS_SHAPE_PAIR_COUNT; ++bucketIndex) {
+			bucketStarts[bucketIndex + 1] += bucketStarts[bucketIndex];
+		}
+		PhysicsPair sortedPairs[PHYSICS_PAIR_JOB_COUNT];
+		U32 bucketOffsets[PHYSICS_SHAPE_PAIR_COUNT];
+		for (U32 bucketIndex = 0; bucketIndex < PHYSICS_SHAPE_PAIR_COUNT; ++bucketIndex) {
+			bucketOffsets[bucketIndex] = bucketStarts[bucketIndex];
+		}
+		for (U32 pairIndex = 0; pairIndex < pairCount; ++pairIndex) {
+			sortedPairs[bucketOffsets[pairBuckets[pairIndex]]++] = orderedPairs[pairIndex];
+		}
+
+		for (U32 bucketIndex = 0; bucketIndex < PHYSICS_SHAPE_PAIR_COUNT; ++bucketIndex) {
+			U32 bucketStart = bucketStarts[bucketIndex];
+			U32 bucketCount = bucketStarts[bucketIndex + 1] - bucketStart;
+			if (bucketCount == 0) {
+				continue;
+			}
+			if (bucketIndex == PHYSICS_BOX_SHAPE_PAIR) {
+				PhysicsCreateContactsBatch(physics, buffer, sortedPairs + bucketStart, bucketCount);
+			} else {
+				// NOTE(final): Shape pairs without a generator, like two planes, never collide
+				ShapeKind kindA = (ShapeKind)(bucketIndex / ShapeKind::ShapeKind_Count);
+				ShapeKind kindB = (ShapeKind)(bucketIndex % ShapeKind::ShapeKind_Count);
+				generate_contacts *generator = GetContactGenerator(kindA, kindB);
+				if (generator) {
+					PhysicsCreateContactsGenerated(physics, buffer, sortedPairs + bucketStart, bucketCount, generator);
+				}
+			}
+		}
+	}
+}
 
-	// Get distance to origin and calculate the region on the minkowski segment
-	Vec2f distanceToOrigin = origin - segmentMinkowski1;
-	F32 regionA = Vec2Dot(segmentMinkowskiAB, distanceToOrigin) / Vec2Dot(segmentMinkowskiAB, segmentMinkowskiAB);
-	F32 percentageA = ScalarClamp01(regionA);
+// NOTE(final): A box face is internal when the tile behind the face tile which is closest to the body is solid.
+//				Internal faces are the seams between boxes, which must never stop a body.
+internal B32 PhysicsTileBoxFaceIsInternal(const PhysicsTileMap *tileMap, const PhysicsTileBox *box, S32 faceIndex, const Vec2f &bodyPos) {
+	S32 bodyTileX = FloorF32ToS32(bodyPos.x / tileMap->tileSize.x);
+	S32 bodyTileY = FloorF32ToS32(bodyPos.y / tileMap->tileSize.y);
+	S32 faceTileX = Max(box->minTile.x, Min(bodyTileX, box->maxTile.x));
+	S32 faceTileY = Max(box->minTile.y, Min(bodyTileY, box->maxTile.y));
+	switch (faceIndex) {
+		case 0:
+		{
+			faceTileY = box->minTile.y;
+		}; break;
+		case 1:
+		{
+			faceTileX = box->minTile.x;
+		}; break;
+		case 2:
+		{
+			faceTileY = box->maxTile.y;
+		}; break;
+		case 3:
+		{
+			faceTileX = box->maxTile.x;
+		}; break;
+		InvalidDefaultCase;
+	}
+	U8 faceCell = PhysicsTileMapGet(tileMap, faceTileX, faceTileY);
+	B32 result = (faceCell & (1 << (PHYSICS_TILE_NEIGHBOUR_SHIFT + faceIndex))) != 0;
+	return(result);
+}
 
-	// Build segment for A
-	Vec2f segmentA1 = bodyA->position + Vec2Hadamard(normal, bodyA->radius) + Vec2Hadamard(tangent, bodyA->radius);
-	Vec2f segmentA2 = bodyA->position + Vec2Hadamard(normal, bodyA->radius) + Vec2Hadamard(invTangent, bodyA->radius);
-	Vec2f segmentAAB = segmentA2 - segmentA1;
+// NOTE(final): Contacts between a dynamic body and the merged tile boxes inside its bounds.
+//				A box face is skipped when the tile behind it at the body position is solid, which fixes ghost collisions on the seams between boxes.
+//				Tiles are tested against the shape bounds, so every shape collides with the tiles like a box.
+internal void PhysicsCreateTileContacts(Physics *physics, PhysicsContactBuffer *buffer, Body *body) {
+	PhysicsTileMap *tileMap = &physics->tileMap;
+	Vec2f bodyPos = physics->bodyData.positions[body->index];
+	Vec2f bodyRadius = physics->bodyData.radii[body->index];
 
-	// Get closest point on segment A by the already calculated clamped region A
-	Vec2f closestOnA = segmentA1 + segmentAAB * percentageA;
+	// NOTE(final): A box covers many tiles, the iterator returns every box once, so there is a single contact per box
+	PhysicsTileBoxIterator boxIterator = PhysicsTileBoxIteratorBegin(tileMap, body->aabb);
+	for (U32 boxIndex = PhysicsTileBoxIteratorNext(&boxIterator); boxIndex != PHYSICS_TILE_NULL_BOX; boxIndex = PhysicsTileBoxIteratorNext(&boxIterator)) {
+		++buffer->tileBoxesTested;
+		const PhysicsTileBox *box = tileMap->boxes + boxIndex;
+		AABB boxBounds = PhysicsTileMapBoxBounds(tileMap, box);
+		Vec2f boxRadius = (boxBounds.max - boxBounds.min) * 0.5f;
+		Vec2f relPos = bodyPos - (boxBounds.min + boxRadius);
+		S32 faceIndex;
+		F32 separation = PhysicsBoxOverlap(relPos, boxRadius + bodyRadius, &faceIndex);
+		if (PhysicsTileBoxFaceIsInternal(tileMap, box, faceIndex, bodyPos)) {
+			continue;
+		}
+		PhysicsContactAdd(physics, buffer, &physics->tileBody, body, globalPhysicsEdgeNormals[faceIndex], -separation, PhysicsTileKeyMake(boxIndex, body->bodyId), PhysicsBoxFeatureMake(faceIndex));
+	}
+}
 
-	// Build segment for B
-	Vec2f segmentB1 = bodyB->position + Vec2Hadamard(invNormal, bodyB->radius) + Vec2Hadamard(invTangent, bodyB->radius);
-	Vec2f segmentB2 = bodyB->position + Vec2Hadamard(invNormal, bodyB->radius) + Vec2Hadamard(tangent, bodyB->radius);
-	Vec2f segmentBAB = segmentB2 - segmentB1;
+inline U32 PhysicsIslandFind(U32 *parents, U32 index) {
+	while (parents[index] != index) {
+		parents[index] = parents[parents[index]];
+		index = parents[index];
+	}
+	return(index);
+}
 
-	// Get distance to closest point and calculate the region on the segment B
-	Vec2f distanceToClosest = closestOnA - segmentB1;
-	F32 regionB = Vec2Dot(segmentBAB, distanceToClosest) / Vec2Dot(segmentBAB, segmentBAB);
-	F32 percentageB = ScalarClamp01(regionB);
+inline void PhysicsIslandUnion(U32 *parents, U32 indexA, U32 indexB) {
+	U32 rootA = PhysicsIslandFind(parents, indexA);
+	U32 rootB = PhysicsIslandFind(parents, indexB);
+	// NOTE(final): The lowest index is always the root, so roots are found first when iterating the bodies
+	if (rootA < rootB) {
+		parents[rootB] = rootA;
+	} else if (rootB < rootA) {
+		parents[rootA] = rootB;
+	}
+}
 
-	// Get closest point on segment B by the already calculated clamped region B
-	Vec2f closestOnB = segmentB1 + segmentBAB * percentageB;
+// NOTE(final): Union-find over all contacts between awake bodies.
+//				Static bodies are not part of any island, otherwise everything on the floor would be one island.
+internal void PhysicsIslandsBuild(Physics *physics) {
+	U32 *parents = physics->islandParents;
+	U32 *islandIds = physics->islandIds;
+	physics->islandContacts = 0;
+	if (physics->contactCount > 0) {
+		physics->islandContacts = PushArray(PhysicsStepMemoryGet(physics), U32, physics->contactCount, MemoryFlag::MemoryFlag_None);
+	}
+	for (U32 bodyIndex = 0; bodyIndex < physics->bodyCount; ++bodyIndex) {
+		Body *body = physics->bodies[bodyIndex];
+		if (PhysicsBodyIsAwake(physics, body)) {
+			parents[bodyIndex] = bodyIndex;
+			body->islandIndex = bodyIndex;
+		} else {
+			body->islandIndex = PHYSICS_ISLAND_NULL;
+		}
+	}
+	for (U32 contactIndex = 0; contactIndex < physics->contactCount; ++contactIndex) {
+		Contact *contact = physics->contacts + contactIndex;
+		if (contact->bodyA->islandIndex != PHYSICS_ISLAND_NULL && contact->bodyB->islandIndex != PHYSICS_ISLAND_NULL) {
+			PhysicsIslandUnion(parents, contact->bodyA->islandIndex, contact->bodyB->islandIndex);
+		}
+	}
 
-	// Skip all edges - required to fix ghost collisions
-	bool skipEdge = false;
-	if ((regionA < PHYSICS_EPSILON || regionA > 1.0 - PHYSICS_EPSILON) || (regionB < PHYSICS_EPSILON || regionB > 1.0 - PHYSICS_EPSILON)) {
-		skipEdge = true;
+	// NOTE(final): Count bodies and contacts per island
+	physics->islandCount = 0;
+	for (U32 bodyIndex = 0; bodyIndex < physics->bodyCount; ++bodyIndex) {
+		if (physics->bodies[bodyIndex]->islandIndex == PHYSICS_ISLAND_NULL) {
+			continue;
+		}
+		U32 root = PhysicsIslandFind(parents, bodyIndex);
+		if (root == bodyIndex) {
+			islandIds[bodyIndex] = physics->islandCount;
+			physics->islands[physics->islandCount++] = {};
+		}
+		islandIds[bodyIndex] = islandIds[root];
+		++physics->islands[islandIds[bodyIndex]].bodyCount;
+	}
+	for (U32 contactIndex = 0; contactIndex < physics->contactCount; ++contactIndex) {
+		Contact *contact = physics->contacts + contactIndex;
+		U32 islandIndex = contact->bodyA->islandIndex != PHYSICS_ISLAND_NULL ? contact->bodyA->islandIndex : contact->bodyB->islandIndex;
+		Assert(islandIndex != PHYSICS_ISLAND_NULL);
+		++physics->islands[islandIds[islandIndex]].contactCount;
 	}
 
-	if (!skipEdge) {
-		Assert(physics->contactCount < ArrayCount(physics->contacts));
-		Contact *contact = &physics->contacts[physics->contactCount++];
-		*contact = {};
-		contact->distance = -separation;
-		contact->normal = normal;
-		contact->bodyA = bodyA;
-		contact->bodyB = bodyB;
+	// NOTE(final): Prefix sum and scatter the bodies and contacts into their island ranges
+	U32 bodyStart = 0;
+	U32 contactStart = 0;
+	for (U32 islandIndex = 0; islandIndex < physics->islandCount; ++islandIndex) {
+		PhysicsIsland *island = physics->islands + islandIndex;
+		island->bodyStart = bodyStart;
+		island->contactStart = contactStart;
+		bodyStart += island->bodyCount;
+		contactStart += island->contactCount;
+		island->bodyCount = 0;
+		island->contactCount = 0;
 	}
+	for (U32 bodyIndex = 0; bodyIndex < physics->bodyCount; ++bodyIndex) {
+		if (physics->bodies[bodyIndex]->islandIndex == PHYSICS_ISLAND_NULL) {
+			continue;
+		}
+		PhysicsIsland *island = physics->islands + islandIds[bodyIndex];
+		physics->islandBodies[island->bodyStart + island->bodyCount++] = bodyIndex;
+	}
+	for (U32 contactIndex = 0; contactIndex < physics->contactCount; ++contactIndex) {
+		Contact *contact = physics->contacts + contactIndex;
+		U32 islandIndex = contact->bodyA->islandIndex != PHYSICS_ISLAND_NULL ? contact->bodyA->islandIndex : contact->bodyB->islandIndex;
+		PhysicsIsland *island = physics->islands + islandIds[islandIndex];
+		physics->islandContacts[island->contactStart + island->contactCount++] = contactIndex;
+	}
+}
+
+// NOTE(final): Updates the rest timers and puts the island to sleep, when all its bodies are resting long enough
+internal void PhysicsIslandSleep(Physics *physics, const PhysicsIsland *island, F32 deltaTime) {
+	U32 *islandBodies = physics->islandBodies + island->bodyStart;
+	F32 minSleepTime = FLOAT_MAX;
+	for (U32 islandBodyIndex = 0; islandBodyIndex < island->bodyCount; ++islandBodyIndex) {
+		Body *body = physics->bodies[islandBodies[islandBodyIndex]];
+		if (Vec2LengthSquared(physics->bodyData.velocities[body->index]) > PHYSICS_SLEEP_VELOCITY_TOLERANCE * PHYSICS_SLEEP_VELOCITY_TOLERANCE) {
+			body->sleepTime = 0;
+		} else {
+			body->sleepTime += deltaTime;
+		}
+		minSleepTime = Min(minSleepTime, body->sleepTime);
+	}
+	if (minSleepTime >= PHYSICS_TIME_TO_SLEEP) {
+		for (U32 islandBodyIndex = 0; islandBodyIndex < island->bodyCount; ++islandBodyIndex) {
+			Body *body = physics->bodies[islandBodies[islandBodyIndex]];
+			physics->bodyData.flags[body->index] &= ~PHYSICS_BODY_FLAG_AWAKE;
+			physics->bodyData.velocities[body->index] = V2();
+			body->sleepNext = physics->bodies[islandBodies[(islandBodyIndex + 1) % island->bodyCount]];
+		}
+	}
+}
+
+// NOTE(final): Islands do not share any dynamic body, so each island can be solved on its own
+internal void PhysicsIslandSolve(Physics *physics, const PhysicsIsland *island, F32 deltaTime) {
+	PhysicsSolverSolveScalar(physics, physics->islandContacts + island->contactStart, island->contactCount, deltaTime);
 }
 
-external Body *PhysicsBodyCreate(Physics *physics, BodyType type, const Vec2f &radius, const Vec2f &pos, F32 density = 1.0f) {
-	Assert(!physics->bodyPool.IsEmpty());
-	Body *body = physics->bodyPool.PopFront();
+external void PhysicsBodyWake(Physics *physics, Body *body) {
+	if (body->type != BodyType::BodyType_Dynamic || PhysicsBodyIsAwake(physics, body)) {
+		return;
+	}
+	// NOTE(final): Wake up the whole sleeping island, otherwise the other bodies would float in the air
+	Body *islandBody = body;
+	do {
+		Body *nextBody = islandBody->sleepNext;
+		physics->bodyData.flags[islandBody->index] |= PHYSICS_BODY_FLAG_AWAKE;
+		islandBody->sleepTime = 0;
+		islandBody->sleepNext = 0;
+		islandBody = nextBody;
+	} while (islandBody && islandBody != body);
+}
+
+inline void PhysicsBodyDataSet(PhysicsBodyData *bodyData, U32 index, U32 flags, const Vec2f &position, const Vec2f &radius, F32 invMass) {
+	bodyData->positions[index] = position;
+	bodyData->prevPositions[index] = position;
+	bodyData->velocities[index] = V2();
+	bodyData->biasVelocities[index] = V2();
+	bodyData->radii[index] = radius;
+	bodyData->invMasses[index] = invMass;
+	bodyData->flags[index] = flags;
+}
+
+// NOTE(final): Half extents of the shape bounds around the body position
+external Vec2f PhysicsShapeGetExtents(const Shape &shape) {
+	const Transform &localTransform = shape.localTransform;
+	Vec2f result = V2();
+	switch (shape.type) {
+		case ShapeType::ShapeType_Circle:
+		{
+			result = V2(shape.circle.radius, shape.circle.radius);
+		}; break;
+		case ShapeType::ShapeType_Plane:
+		{
+			Vec2f tangent = localTransform.rot.col2 * (shape.plane.len * 0.5f);
+			result = V2(Abs(tangent.x), Abs(tangent.y));
+		}; break;
+		case ShapeType::ShapeType_LineSegment:
+		case ShapeType::ShapeType_Box:
+		case ShapeType::ShapeType_Polygon:
+		{
+			const EdgeShape *edge = GetEdgeShape((Shape *)&shape);
+			for (U32 vertexIndex = 0; vertexIndex < edge->vertexCount; ++vertexIndex) {
+				Vec2f v = Vec2MultMat2(edge->localVerts[vertexIndex], localTransform.rot);
+				result = Vec2Max(result, V2(Abs(v.x), Abs(v.y)));
+			}
+		}; break;
+		InvalidDefaultCase;
+	}
+	result += V2(Abs(localTransform.pos.x), Abs(localTransform.pos.y));
+	return(result);
+}
+
+// NOTE(final): Takes a pool slot and appends the body to the dense body data, the broadphase is not touched.
+//				Returns null when the pool is full.
+internal Body *PhysicsBodyAllocate(Physics *physics, const BodyDesc &desc) {
+	// NOTE(final): Every used slot holds a body in the dense body data, so the pool is full when the body data is full
+	if (physics->bodyCount >= PHYSICS_MAX_BODY_POOL_COUNT) {
+		return(0);
+	}
+	Body *body;
+	if (physics->freeBodySlot != PHYSICS_BODY_NULL_SLOT) {
+		body = physics->bodiesBase + physics->freeBodySlot;
+		physics->freeBodySlot = body->nextFree;
+	} else {
+		Assert(physics->bodySlotCount < PHYSICS_MAX_BODY_POOL_COUNT);
+		body = physics->bodiesBase + physics->bodySlotCount++;
+	}
+	U32 generation = body->generation;
 	*body = {};
-	physics->usedBodies.PushBack(body);
-	PhysicsBodiesRefresh(physics);
+	body->generation = generation;
+	body->nextFree = PHYSICS_BODY_NULL_SLOT;
 
 	body->bodyId = ++physics->bodyIdCounter;
-	body->type = type;
-	body->position = pos;
-	body->radius = radius;
+	body->type = desc.type;
+	body->index = physics->bodyCount++;
+	Vec2f radius = desc.radius;
+	if (desc.shape) {
+		// NOTE(final): Box pairs take the batched box contacts, which read the position and the radius of the body only
+		Assert(desc.shape->type != ShapeType::ShapeType_Box || TransformIsIdentity(desc.shape->localTransform));
+		body->shape = *desc.shape;
+		radius = PhysicsShapeGetExtents(body->shape);
+	} else {
+		body->shape = MakeBoxShape(desc.radius);
+	}
+	body->shape.shapeId = body->bodyId;
+	CookShape(&body->shape, desc.density);
+	body->aabb = AABBFromCenterExt(desc.position, radius);
+	body->filter = desc.filter ? *desc.filter : PhysicsFilterMake();
+	body->proxyId = PHYSICS_BROADPHASE_NULL_PROXY;
+	body->islandIndex = PHYSICS_ISLAND_NULL;
+	body->userData = desc.userData;
+	physics->bodies[body->index] = body;
 
-	F32 mass = (radius.x * radius.y * 2.0f) * density;
-	body->invMass = mass > 0 ? 1.0f / mass : 0;
+	// NOTE(final): Static bodies have infinite mass, so the solver never needs to check the body type
+	F32 mass = body->shape.massData.mass;
+	F32 invMass = (desc.type == BodyType::BodyType_Dynamic && mass > 0) ? 1.0f / mass : 0;
+	U32 flags = desc.type == BodyType::BodyType_Dynamic ? (PHYSICS_BODY_FLAG_DYNAMIC | PHYSICS_BODY_FLAG_AWAKE) : 0;
+	if (desc.type == BodyType::BodyType_Dynamic && desc.isBullet) {
+		flags |= PHYSICS_BODY_FLAG_BULLET;
+	}
+	if (desc.isSensor) {
+		flags |= PHYSICS_BODY_FLAG_SENSOR;
+	}
+	PhysicsBodyDataSet(&physics->bodyData, body->index, flags, desc.position, radius, invMass);
 
 	return(body);
 }
 
-external void PhysicsBodyRemove(Physics *physics, Body *body) {
-	physics->usedBodies.Remove(body);
+// NOTE(final): Moves the last body into the hole and returns the slot to the free list, the broadphase must be updated already
+internal void PhysicsBodyRelease(Physics *physics, Body *body) {
+	// NOTE(final): The vacated slot must not be seen as awake by the SIMD kernels
+	PhysicsBodyData *bodyData = &physics->bodyData;
+	U32 lastIndex = --physics->bodyCount;
+	if (body->index != lastIndex) {
+		Body *lastBody = physics->bodies[lastIndex];
+		lastBody->index = body->index;
+		physics->bodies[body->index] = lastBody;
+		bodyData->positions[body->index] = bodyData->positions[lastIndex];
+		bodyData->prevPositions[body->index] = bodyData->prevPositions[lastIndex];
+		bodyData->velocities[body->index] = bodyData->velocities[lastIndex];
+		bodyData->biasVelocities[body->index] = bodyData->biasVelocities[lastIndex];
+		bodyData->radii[body->index] = bodyData->radii[lastIndex];
+		bodyData->invMasses[body->index] = bodyData->invMasses[lastIndex];
+		bodyData->flags[body->index] = bodyData->flags[lastIndex];
+	}
+	physics->bodies[lastIndex] = 0;
+	PhysicsBodyDataSet(bodyData, lastIndex, 0, V2(), V2(), 0);
+
+	U32 slot = (U32)(body - physics->bodiesBase);
+	U32 generation = body->generation;
 	*body = {};
-	physics->bodyPool.PushBack(body);
+	body->generation = generation + 1;
+	body->nextFree = physics->freeBodySlot;
+	physics->freeBodySlot = slot;
+
+	// NOTE(final): A slot reused and released again in the same frame is pending once only
+	if (!physics->removedSlots[slot]) {
+		physics->removedSlots[slot] = 1;
+		physics->pendingRemovedSlots[physics->pendingRemovedCount++] = slot;
+	}
+}
+
+inline B32 PhysicsBodySlotIsRemoved(const Physics *physics, const Body *body) {
+	// NOTE(final): The tile body is not part of the pool and is never removed
+	B32 result = false;
+	if (body >= physics->bodiesBase && body < physics->bodiesBase + PHYSICS_MAX_BODY_POOL_COUNT) {
+		result = physics->removedSlots[body - physics->bodiesBase] != 0;
+	}
+	return(result);
+}
+
+// NOTE(final): Bodies resting on a removed body must fall down, so all contact partners which are not removed as well are woken up.
+//				Overlaps with a removed body end without an event, because the caller knows about the removal already.
+//				Both go over the contacts and overlaps of the last step once for all bodies removed since then.
+internal void PhysicsBodiesRemovedFlush(Physics *physics) {
+	for (U32 contactIndex = 0; contactIndex < physics->contactCount; ++contactIndex) {
+		Contact *contact = physics->contacts + contactIndex;
+		B32 removedA = PhysicsBodySlotIsRemoved(physics, contact->bodyA);
+		B32 removedB = PhysicsBodySlotIsRemoved(physics, contact->bodyB);
+		if (removedA && !removedB) {
+			PhysicsBodyWake(physics, contact->bodyB);
+		} else if (removedB && !removedA) {
+			PhysicsBodyWake(physics, contact->bodyA);
+		}
+	}
+
+	U32 overlapCount = 0;
+	for (U32 overlapIndex = 0; overlapIndex < physics->sensorOverlapCount; ++overlapIndex) {
+		PhysicsSensorOverlap *overlap = physics->sensorOverlaps + overlapIndex;
+		if (!PhysicsBodySlotIsRemoved(physics, overlap->sensor) && !PhysicsBodySlotIsRemoved(physics, overlap->visitor)) {
+			physics->sensorOverlaps[overlapCount++] = *overlap;
+		}
+	}
+	physics->sensorOverlapCount = overlapCount;
 
-	PhysicsBodiesRefresh(physics);
+	for (U32 pendingIndex = 0; pendingIndex < physics->pendingRemovedCount; ++pendingIndex) {
+		physics->removedSlots[physics->pendingRemovedSlots[pendingIndex]] = 0;
+	}
+	physics->pendingRemovedCount = 0;
+}
+
+// NOTE(final): Returns a null handle when the pool is full
+external BodyHandle PhysicsBodyCreate(Physics *physics, BodyType type, const Vec2f &radius, const Vec2f &pos, F32 density = 1.0f) {
+	BodyDesc desc = {};
+	desc.type = type;
+	desc.radius = radius;
+	desc.position = pos;
+	desc.density = density;
+	BodyHandle result = {};
+	Body *body = PhysicsBodyAllocate(physics, desc);
+	if (body) {
+		PhysicsBroadphaseInsert(physics, body);
+		result = PhysicsBodyHandleGet(physics, body);
+	}
+	return(result);
+}
+
+external BodyHandle PhysicsBodyCreateShape(Physics *physics, BodyType type, const Shape &shape, const Vec2f &pos, F32 density = 1.0f) {
+	BodyDesc desc = {};
+	desc.type = type;
+	desc.position = pos;
+	desc.density = density;
+	desc.shape = &shape;
+	BodyHandle result = {};
+	Body *body = PhysicsBodyAllocate(physics, desc);
+	if (body) {
+		PhysicsBroadphaseInsert(physics, body);
+		result = PhysicsBodyHandleGet(physics, body);
+	}
+	return(result);
+}
+
+external B32 PhysicsBodyRemove(Physics *physics, const BodyHandle &handle) {
+	Body *body = PhysicsBodyGet(physics, handle);
+	if (!body) {
+		return false;
+	}
+	// NOTE(final): The contact partners are woken up at the start of the next step, so removing many bodies one by one stays linear
+	PhysicsBodyWake(physics, body);
+	PhysicsBroadphaseRemove(physics, body);
+	PhysicsBodyRelease(physics, body);
+	return true;
+}
+
+// NOTE(final): The new bodies are appended to the dense body array, so the broadphase gets them as one contiguous range.
+//				Descs which do not fit into the pool are skipped and get a null handle, returns the number of created bodies.
+external U32 PhysicsBodiesCreateBatch(Physics *physics, const BodyDesc *descs, U32 descCount, BodyHandle *outHandles) {
+	U32 firstIndex = physics->bodyCount;
+	U32 createCount = Min(descCount, PHYSICS_MAX_BODY_POOL_COUNT - physics->bodyCount);
+	for (U32 descIndex = 0; descIndex < descCount; ++descIndex) {
+		BodyHandle handle = {};
+		if (descIndex < createCount) {
+			Body *body = PhysicsBodyAllocate(physics, descs[descIndex]);
+			handle = PhysicsBodyHandleGet(physics, body);
+		}
+		if (outHandles) {
+			outHandles[descIndex] = handle;
+		}
+	}
+	if (createCount > 0) {
+		PhysicsBroadphaseInsertBatch(physics, physics->bodies + firstIndex, createCount);
+	}
+	return(createCount);
+}
+
+// NOTE(final): Stale and duplicated handles are skipped, returns the number of removed bodies
+external U32 PhysicsBodiesRemoveBatch(Physics *physics, const BodyHandle *handles, U32 handleCount) {
+	if (handleCount == 0) {
+		return(0);
+	}
+	TemporaryMemory tempMemory = TemporaryMemoryBegin(&physics->physicsMemory);
+	Body **removeBodies = PushArray(&physics->physicsMemory, Body *, handleCount, MemoryFlag::MemoryFlag_None);
+	U32 removeCount = 0;
+	for (U32 handleIndex = 0; handleIndex < handleCount; ++handleIndex) {
+		Body *body = PhysicsBodyGet(physics, handles[handleIndex]);
+		if (!body || (physics->bodyData.flags[body->index] & PHYSICS_BODY_FLAG_REMOVED)) {
+			continue;
+		}
+		PhysicsBodyWake(physics, body);
+		physics->bodyData.flags[body->index] |= PHYSICS_BODY_FLAG_REMOVED;
+		removeBodies[removeCount++] = body;
+	}
+	PhysicsBroadphaseRemoveBatch(physics, removeBodies, removeCount);
+	for (U32 removeIndex = 0; removeIndex < removeCount; ++removeIndex) {
+		PhysicsBodyRelease(physics, removeBodies[removeIndex]);
+	}
+	PhysicsBodiesRemovedFlush(physics);
+	TemporaryMemoryEnd(&tempMemory);
+	return(removeCount);
+}
+
+external void PhysicsTileSet(Physics *physics, S32 tileX, S32 tileY, B32 solid) {
+	PhysicsTileMap *tileMap = &physics->tileMap;
+	PhysicsTileMapSet(tileMap, tileX, tileY, solid);
+
+	// NOTE(final): Sleeping bodies touching the changed tile must react to it
+	Vec2f tileMin = Vec2Hadamard(V2((F32)tileX, (F32)tileY), tileMap->tileSize);
+	AABB tileBounds = AABBFromMinMax(tileMin, tileMin + tileMap->tileSize);
+	for (U32 bodyIndex = 0; bodyIndex < physics->bodyCount; ++bodyIndex) {
+		Body *body = physics->bodies[bodyIndex];
+		if (body->type == BodyType::BodyType_Dynamic && !PhysicsBodyIsAwake(physics, body) && AABBOverlap(body->aabb, tileBounds)) {
+			PhysicsBodyWake(physics, body);
+		}
+	}
 }
 
 external void PhysicsClear(Physics *physics) {
-	ZeroArray(physics->bodiesBase, PHYSICS_MAX_BODY_POOL_COUNT);
-	physics->bodyPool.Init();
-	for (U32 bodyIndex = 0; bodyIndex < PHYSICS_MAX_BODY_POOL_COUNT; ++bodyIndex) {
-		Body *body = physics->bodiesBase + bodyIndex;
-		physics->bodyPool.PushBack(body);
+	// NOTE(final): The generations are kept, so handles from before the clear stay invalid
+	for (U32 slot = 0; slot < physics->bodySlotCount; ++slot) {
+		Body *body = physics->bodiesBase + slot;
+		U32 generation = body->generation;
+		*body = {};
+		body->generation = generation + 1;
+	}
+	physics->bodySlotCount = 0;
+	physics->freeBodySlot = PHYSICS_BODY_NULL_SLOT;
+	for (U32 pendingIndex = 0; pendingIndex < physics->pendingRemovedCount; ++pendingIndex) {
+		physics->removedSlots[physics->pendingRemovedSlots[pendingIndex]] = 0;
 	}
+	physics->pendingRemovedCount = 0;
 
-	physics->usedBodies.Init();
 	ZeroArray(physics->bodies, ArrayCount(physics->bodies));
+	for (U32 bodyIndex = 0; bodyIndex < physics->bodyCount; ++bodyIndex) {
+		PhysicsBodyDataSet(&physics->bodyData, bodyIndex, 0, V2(), V2(), 0);
+	}
+	physics->bodies[PHYSICS_TILE_BODY_INDEX] = &physics->tileBody;
 	physics->bodyCount = 0;
 	physics->bodyIdCounter = 0;
+	physics->pairCount = 0;
+	physics->contactCount = 0;
+	physics->prevContactCount = 0;
+	physics->islandCount = 0;
+	physics->sensorPairCount = 0;
+	physics->sensorOverlapCount = 0;
+	physics->sensorEventCount = 0;
+	physics->sensorEventOverflowCount = 0;
+	physics->stepAccumulator = 0;
+	physics->interpolationAlpha = 0;
+	PhysicsBroadphaseClear(physics);
+	PhysicsTileMapClear(&physics->tileMap);
 }
 
-external void PhysicsInit(Physics *physics, const Vec2f &gravity) {
+external void PhysicsInit(Physics *physics, const Vec2f &gravity, const Vec2f &tileSize, PhysicsBroadphaseType broadphaseType, PhysicsSolverType solverType) {
+	Assert(!physics->jobs || physics->jobs->jobSystem->workerCount <= PHYSICS_MAX_WORKER_COUNT);
 	physics->bodiesBase = PushArray(&physics->physicsMemory, Body, PHYSICS_MAX_BODY_POOL_COUNT);
+	physics->removedSlots = PushArray(&physics->physicsMemory, U8, PHYSICS_MAX_BODY_POOL_COUNT);
+	physics->pendingRemovedSlots = PushArray(&physics->physicsMemory, U32, PHYSICS_MAX_BODY_POOL_COUNT);
+	physics->pendingRemovedCount = 0;
+	physics->bodyData.positions = PushArray(&physics->physicsMemory, Vec2f, PHYSICS_BODY_DATA_COUNT);
+	physics->bodyData.prevPositions = PushArray(&physics->physicsMemory, Vec2f, PHYSICS_BODY_DATA_COUNT);
+	physics->bodyData.velocities = PushArray(&physics->physicsMemory, Vec2f, PHYSICS_BODY_DATA_COUNT);
+	physics->bodyData.biasVelocities = PushArray(&physics->physicsMemory, Vec2f, PHYSICS_BODY_DATA_COUNT);
+	physics->bodyData.radii = PushArray(&physics->physicsMemory, Vec2f, PHYSICS_BODY_DATA_COUNT);
+	physics->bodyData.invMasses = PushArray(&physics->physicsMemory, F32, PHYSICS_BODY_DATA_COUNT);
+	physics->bodyData.flags = PushArray(&physics->physicsMemory, U32, PHYSICS_BODY_DATA_COUNT);
+	physics->pairs = PushArray(&physics->physicsMemory, PhysicsPair, PHYSICS_MAX_PAIR_COUNT);
+	physics->stepMemory[0] = MemoryBlockCreateFrom(&physics->physicsMemory, PHYSICS_STEP_MEMORY_SIZE, MemoryFlag::MemoryFlag_None);
+	physics->stepMemory[1] = MemoryBlockCreateFrom(&physics->physicsMemory, PHYSICS_STEP_MEMORY_SIZE, MemoryFlag::MemoryFlag_None);
+	physics->stepIndex = 0;
+	physics->contactMemory = MemoryBlockCreateFrom(&physics->physicsMemory, PHYSICS_CONTACT_MEMORY_SIZE, MemoryFlag::MemoryFlag_None);
+	physics->contactMemoryUsed = 0;
+	physics->contacts = 0;
+	physics->contactCount = 0;
+	physics->prevContacts = 0;
+	physics->prevContactCount = 0;
+	physics->islandParents = PushArray(&physics->physicsMemory, U32, PHYSICS_MAX_BODY_POOL_COUNT);
+	physics->islandIds = PushArray(&physics->physicsMemory, U32, PHYSICS_MAX_BODY_POOL_COUNT);
+	physics->islands = PushArray(&physics->physicsMemory, PhysicsIsland, PHYSICS_MAX_BODY_POOL_COUNT);
+	physics->islandBodies = PushArray(&physics->physicsMemory, U32, PHYSICS_MAX_BODY_POOL_COUNT);
+	physics->bullets = PushArray(&physics->physicsMemory, PhysicsBullet, PHYSICS_MAX_BULLET_COUNT);
+	physics->sensorPairs = PushArray(&physics->physicsMemory, PhysicsPair, PHYSICS_MAX_SENSOR_PAIR_COUNT);
+	physics->sensorOverlaps = PushArray(&physics->physicsMemory, PhysicsSensorOverlap, PHYSICS_MAX_SENSOR_OVERLAP_COUNT);
+	physics->sensorEvents = PushArray(&physics->physicsMemory, PhysicsSensorEvent, PHYSICS_MAX_SENSOR_EVENT_COUNT);
+	physics->sensorPairCount = 0;
+	physics->sensorOverlapCount = 0;
+	physics->sensorEventCount = 0;
+	physics->sensorEventOverflowCount = 0;
+	PhysicsSolverInit(&physics->solver, &physics->physicsMemory, solverType, PHYSICS_MAX_BODY_POOL_COUNT);
+
+#ifdef _DEBUG
+	// NOTE(final): The SIMD kernels must give the same results as the scalar versions
+	U32 mismatchCount = CollisionSIMDSelfCheck(1, 1024);
+	Assert(mismatchCount == 0);
+#endif
 
-	physics->bodyPool.Init();
-	for (U32 bodyIndex = 0; bodyIndex < PHYSICS_MAX_BODY_POOL_COUNT; ++bodyIndex) {
-		Body *body = physics->bodiesBase + bodyIndex;
-		physics->bodyPool.PushBack(body);
+	physics->broadphaseType = broadphaseType;
+	PhysicsBroadphaseInit(physics, tileSize);
+
+	for (U32 slot = 0; slot < PHYSICS_MAX_BODY_POOL_COUNT; ++slot) {
+		physics->bodiesBase[slot].generation = 1;
 	}
+	physics->bodySlotCount = 0;
+	physics->freeBodySlot = PHYSICS_BODY_NULL_SLOT;
 
-	physics->usedBodies.Init();
+	// NOTE(final): Shared static body for all tile contacts
+	physics->tileBody = {};
+	physics->tileBody.type = BodyType::BodyType_Static;
+	physics->tileBody.index = PHYSICS_TILE_BODY_INDEX;
+	physics->tileBody.filter = PhysicsFilterMake();
+	physics->bodies[PHYSICS_TILE_BODY_INDEX] = &physics->tileBody;
+	PhysicsBodyDataSet(&physics->bodyData, PHYSICS_TILE_BODY_INDEX, 0, V2(), V2(), 0);
+	physics->tileBody.proxyId = PHYSICS_BROADPHASE_NULL_PROXY;
+	physics->tileBody.islandIndex = PHYSICS_ISLAND_NULL;
 
 	physics->gravity = gravity;
+
+	PhysicsStepRateSet(physics, PHYSICS_DEFAULT_STEP_RATE, PHYSICS_DEFAULT_MAX_STEP_COUNT);
+	physics->stepAccumulator = 0;
+	physics->interpolationAlpha = 0;
 }
 
-external void PhysicsUpdate(Physics * physics, InputState *input)
-{
-	// NOTE(final): Integrate acceleration
-	for (U32 bodyIndex = 0; bodyIndex < physics->bodyCount; ++bodyIndex) {
+external void PhysicsStepRateSet(Physics *physics, F32 stepRate, U32 maxStepCount) {
+	Assert(stepRate > 0);
+	Assert(maxStepCount > 0);
+	physics->stepDeltaTime = 1.0f / stepRate;
+	physics->maxStepCount = maxStepCount;
+}
+
+// NOTE(final): Expands the awake flags of four bodies into two masks, each covering the x and y of two bodies
+inline void PhysicsBodyAwakeMasks(const U32 *flags, __m128 *outMaskLow, __m128 *outMaskHigh) {
+	__m128i awakeFlag = _mm_set1_epi32(PHYSICS_BODY_FLAG_AWAKE);
+	__m128i awake = _mm_cmpeq_epi32(_mm_and_si128(_mm_loadu_si128((const __m128i *)flags), awakeFlag), awakeFlag);
+	*outMaskLow = _mm_castsi128_ps(_mm_unpacklo_epi32(awake, awake));
+	*outMaskHigh = _mm_castsi128_ps(_mm_unpackhi_epi32(awake, awake));
+}
+
+// NOTE(final): Adds the gravity velocity change of this step to all awake bodies, four bodies at once.
+//				Vec2f arrays are interleaved x and y, so one SSE register holds two bodies.
+//				The body end is rounded up to four, the bodies after the count have no flags and are never changed.
+internal void PhysicsIntegrateGravity(PhysicsBodyData *bodyData, U32 bodyStart, U32 bodyEnd, const Vec2f &gravity, F32 deltaTime) {
+	Assert(bodyStart % 4 == 0);
+	Vec2f gravityStep = gravity * deltaTime;
+	__m128 gravityXY = _mm_setr_ps(gravityStep.x, gravityStep.y, gravityStep.x, gravityStep.y);
+	for (U32 bodyIndex = bodyStart; bodyIndex < bodyEnd; bodyIndex += 4) {
+		__m128 maskLow, maskHigh;
+		PhysicsBodyAwakeMasks(bodyData->flags + bodyIndex, &maskLow, &maskHigh);
+		F32 *velocities = (F32 *)(bodyData->velocities + bodyIndex);
+		__m128 velocityLow = _mm_loadu_ps(velocities + 0);
+		__m128 velocityHigh = _mm_loadu_ps(velocities + 4);
+		velocityLow = _mm_add_ps(velocityLow, _mm_and_ps(gravityXY, maskLow));
+		velocityHigh = _mm_add_ps(velocityHigh, _mm_and_ps(gravityXY, maskHigh));
+		_mm_storeu_ps(velocities + 0, velocityLow);
+		_mm_storeu_ps(velocities + 4, velocityHigh);
+	}
+}
+
+// NOTE(final): Integrates the velocity and the bias velocity of all awake bodies, four bodies at once.
+//				The bias velocity is used for this step only and is cleared for every body.
+internal void PhysicsIntegrateVelocity(PhysicsBodyData *bodyData, U32 bodyStart, U32 bodyEnd, F32 deltaTime) {
+	Assert(bodyStart % 4 == 0);
+	__m128 dt = _mm_set1_ps(deltaTime);
+	__m128 zero = _mm_setzero_ps();
+	for (U32 bodyIndex = bodyStart; bodyIndex < bodyEnd; bodyIndex += 4) {
+		__m128 maskLow, maskHigh;
+		PhysicsBodyAwakeMasks(bodyData->flags + bodyIndex, &maskLow, &maskHigh);
+		F32 *positions = (F32 *)(bodyData->positions + bodyIndex);
+		F32 *velocities = (F32 *)(bodyData->velocities + bodyIndex);
+		F32 *biasVelocities = (F32 *)(bodyData->biasVelocities + bodyIndex);
+		__m128 motionLow = _mm_mul_ps(_mm_add_ps(_mm_loadu_ps(velocities + 0), _mm_loadu_ps(biasVelocities + 0)), dt);
+		__m128 motionHigh = _mm_mul_ps(_mm_add_ps(_mm_loadu_ps(velocities + 4), _mm_loadu_ps(biasVelocities + 4)), dt);
+		_mm_storeu_ps(positions + 0, _mm_add_ps(_mm_loadu_ps(positions + 0), _mm_and_ps(motionLow, maskLow)));
+		_mm_storeu_ps(positions + 4, _mm_add_ps(_mm_loadu_ps(positions + 4), _mm_and_ps(motionHigh, maskHigh)));
+		_mm_storeu_ps(biasVelocities + 0, zero);
+		_mm_storeu_ps(biasVelocities + 4, zero);
+	}
+}
+
+// NOTE(final): Adds a job for every element of the job data and waits until all are done.
+//				Without the platform jobs the jobs are run in order on the calling thread.
+internal void PhysicsJobsRun(Physics *physics, job_callback *callback, void *jobs, memory_size jobSize, U32 jobCount) {
+	PlatformJobs *platformJobs = physics->jobs;
+	JobCounter counter = JobCounterCreate();
+	for (U32 jobIndex = 0; jobIndex < jobCount; ++jobIndex) {
+		void *data = (U8 *)jobs + jobIndex * jobSize;
+		if (platformJobs) {
+			platformJobs->PlatformAddJob(platformJobs->jobSystem, callback, data, &counter);
+		} else {
+			callback(data, 0);
+		}
+	}
+	if (platformJobs) {
+		platformJobs->PlatformWaitForJobs(platformJobs->jobSystem, &counter);
+	}
+}
+
+struct PhysicsIntegrateJob {
+	Physics *physics;
+	U32 bodyStart;
+	U32 bodyEnd;
+	F32 deltaTime;
+};
+
+// NOTE(final): Integrates the gravity and updates the bounds, extended by the motion of this step to keep speculative contacts.
+//				Sleeping bodies keep their bounds.
+internal JOB_CALLBACK(PhysicsIntegrateGravityJob) {
+	PhysicsIntegrateJob *job = (PhysicsIntegrateJob *)data;
+	Physics *physics = job->physics;
+	PhysicsBodyData *bodyData = &physics->bodyData;
+	PhysicsIntegrateGravity(bodyData, job->bodyStart, job->bodyEnd, physics->gravity, job->deltaTime);
+	for (U32 bodyIndex = job->bodyStart; bodyIndex < job->bodyEnd; ++bodyIndex) {
+		U32 flags = bodyData->flags[bodyIndex];
+		if ((flags & PHYSICS_BODY_FLAG_DYNAMIC) && !(flags & PHYSICS_BODY_FLAG_AWAKE)) {
+			continue;
+		}
 		Body *body = physics->bodies[bodyIndex];
-		if (body->type == BodyType::BodyType_Dynamic) {
-			body->velocity += physics->gravity;
+		body->aabb = AABBFromCenterExt(bodyData->positions[bodyIndex], bodyData->radii[bodyIndex]);
+		if (flags & PHYSICS_BODY_FLAG_DYNAMIC) {
+			Vec2f motion = bodyData->velocities[bodyIndex] * job->deltaTime;
+			body->aabb.min += Vec2Min(motion, V2());
+			body->aabb.max += Vec2Max(motion, V2());
 		}
 	}
+}
 
-	// NOTE(final): Create contacts
-	physics->contactCount = 0;
-	for (U32 bodyIndexA = 0; bodyIndexA < physics->bodyCount; ++bodyIndexA) {
-		Body *bodyA = physics->bodies[bodyIndexA];
-		for (U32 bodyIndexB = bodyIndexA + 1; bodyIndexB < physics->bodyCount; ++bodyIndexB) {
-			Body *bodyB = physics->bodies[bodyIndexB];
-			if (bodyA->type == BodyType::BodyType_Dynamic || bodyB->type == BodyType::BodyType_Dynamic) {
-				PhysicsCreateContacts(physics, bodyA, bodyB);
+internal JOB_CALLBACK(PhysicsIntegrateVelocityJob) {
+	PhysicsIntegrateJob *job = (PhysicsIntegrateJob *)data;
+	PhysicsIntegrateVelocity(&job->physics->bodyData, job->bodyStart, job->bodyEnd, job->deltaTime);
+}
+
+// NOTE(final): Every body is integrated on its own, so the bodies are split into fixed ranges
+internal void PhysicsIntegrateJobsRun(Physics *physics, job_callback *callback, F32 deltaTime) {
+	PhysicsIntegrateJob jobs[(PHYSICS_MAX_BODY_POOL_COUNT + PHYSICS_INTEGRATE_JOB_COUNT - 1) / PHYSICS_INTEGRATE_JOB_COUNT];
+	U32 jobCount = 0;
+	for (U32 bodyStart = 0; bodyStart < physics->bodyCount; bodyStart += PHYSICS_INTEGRATE_JOB_COUNT) {
+		PhysicsIntegrateJob *job = jobs + jobCount++;
+		job->physics = physics;
+		job->bodyStart = bodyStart;
+		job->bodyEnd = Min(bodyStart + PHYSICS_INTEGRATE_JOB_COUNT, physics->bodyCount);
+		job->deltaTime = deltaTime;
+	}
+	PhysicsJobsRun(physics, callback, jobs, sizeof(PhysicsIntegrateJob), jobCount);
+}
+
+struct PhysicsContactJob {
+	Physics *physics;
+	// NOTE(final): Range of candidate pairs, or of bodies for the tile contacts
+	U32 start;
+	U32 count;
+	B32 isTileJob;
+	PhysicsContactRange *range;
+};
+
+internal JOB_CALLBACK(PhysicsContactsJob) {
+	PhysicsContactJob *job = (PhysicsContactJob *)data;
+	Physics *physics = job->physics;
+	PhysicsContactBuffer *buffer = physics->contactBuffers + workerIndex;
+	PhysicsContactRangeBegin(job->range, buffer);
+	if (job->isTileJob) {
+		for (U32 bodyIndex = job->start; bodyIndex < job->start + job->count; ++bodyIndex) {
+			Body *body = physics->bodies[bodyIndex];
+			U32 flags = physics->bodyData.flags[bodyIndex];
+			if ((flags & PHYSICS_BODY_FLAG_AWAKE) && !(flags & PHYSICS_BODY_FLAG_SENSOR) && PhysicsBodiesShouldCollide(physics, body, &physics->tileBody)) {
+				PhysicsCreateTileContacts(physics, buffer, body);
 			}
 		}
+	} else {
+		PhysicsCreateContacts(physics, buffer, physics->pairs + job->start, job->count);
 	}
+	PhysicsContactRangeEnd(job->range);
+}
 
-	// Solve contacts
-	for (U32 iteration = 0; iteration < PHYSICS_MAX_SOLVER_ITERATION_COUNT; iteration++) {
-		for (U32 contactIndex = 0; contactIndex < physics->contactCount; contactIndex++) {
-			Contact *contact = physics->contacts + contactIndex;
-			Body *bodyA = contact->bodyA;
-			Body *bodyB = contact->bodyB;
+// NOTE(final): Candidate pairs and tile bodies are split into fixed ranges, every job writes into the contact buffer of its worker.
+//				The jobs and the contact ranges are taken from the step memory.
+internal void PhysicsContactJobsRun(Physics *physics) {
+	U32 pairJobCount = (physics->pairCount + PHYSICS_PAIR_JOB_COUNT - 1) / PHYSICS_PAIR_JOB_COUNT;
+	U32 tileJobCount = physics->tileMap.solidCount > 0 ? (physics->bodyCount + PHYSICS_TILE_JOB_COUNT - 1) / PHYSICS_TILE_JOB_COUNT : 0;
+	U32 jobCount = pairJobCount + tileJobCount;
+	physics->contactRangeCount = jobCount;
+	if (jobCount == 0) {
+		return;
+	}
+	MemoryBlock *stepMemory = PhysicsStepMemoryGet(physics);
+	PhysicsContactJob *jobs = PushArray(stepMemory, PhysicsContactJob, jobCount, MemoryFlag::MemoryFlag_None);
+	physics->contactRanges = PushArray(stepMemory, PhysicsContactRange, jobCount, MemoryFlag::MemoryFlag_None);
+	for (U32 jobIndex = 0; jobIndex < jobCount; ++jobIndex) {
+		PhysicsContactJob *job = jobs + jobIndex;
+		job->physics = physics;
+		job->isTileJob = jobIndex >= pairJobCount;
+		if (job->isTileJob) {
+			job->start = (jobIndex - pairJobCount) * PHYSICS_TILE_JOB_COUNT;
+			job->count = Min(PHYSICS_TILE_JOB_COUNT, physics->bodyCount - job->start);
+		} else {
+			job->start = jobIndex * PHYSICS_PAIR_JOB_COUNT;
+			job->count = Min(PHYSICS_PAIR_JOB_COUNT, physics->pairCount - job->start);
+		}
+		job->range = physics->contactRanges + jobIndex;
+	}
+	PhysicsJobsRun(physics, PhysicsContactsJob, jobs, sizeof(PhysicsContactJob), jobCount);
+}
+
+// NOTE(final): Collects the awake bullets with their start position and the bodies of their candidate pairs, before the positions are integrated.
+//				Bullets are no targets of other bullets, these are kept apart by the contacts only. Sensors are never swept.
+internal void PhysicsBulletsBegin(Physics *physics) {
+	const U32 *flags = physics->bodyData.flags;
+	U32 bulletFlags = PHYSICS_BODY_FLAG_BULLET | PHYSICS_BODY_FLAG_AWAKE;
+	physics->bulletCount = 0;
+	for (U32 bodyIndex = 0; bodyIndex < physics->bodyCount && physics->bulletCount < PHYSICS_MAX_BULLET_COUNT; ++bodyIndex) {
+		if ((flags[bodyIndex] & (bulletFlags | PHYSICS_BODY_FLAG_SENSOR)) == bulletFlags) {
+			PhysicsBullet *bullet = physics->bullets + physics->bulletCount++;
+			bullet->bodyIndex = bodyIndex;
+			bullet->start = physics->bodyData.positions[bodyIndex];
+			bullet->targetCount = 0;
+		}
+	}
+	physics->stats.bulletCount = physics->bulletCount;
+	if (physics->bulletCount == 0) {
+		return;
+	}
+	for (U32 pairIndex = 0; pairIndex < physics->pairCount; ++pairIndex) {
+		const PhysicsPair *pair = physics->pairs + pairIndex;
+		Body *pairBodies[2] = { pair->bodyA, pair->bodyB };
+		for (U32 side = 0; side < 2; ++side) {
+			Body *body = pairBodies[side];
+			Body *target = pairBodies[!side];
+			if (!(flags[body->index] & PHYSICS_BODY_FLAG_BULLET) || (flags[target->index] & PHYSICS_BODY_FLAG_BULLET)) {
+				continue;
+			}
+			for (U32 bulletIndex = 0; bulletIndex < physics->bulletCount; ++bulletIndex) {
+				PhysicsBullet *bullet = physics->bullets + bulletIndex;
+				if (bullet->bodyIndex == body->index) {
+					if (bullet->targetCount < PHYSICS_MAX_BULLET_TARGET_COUNT) {
+						bullet->targets[bullet->targetCount++] = target;
+					}
+					break;
+				}
+			}
+		}
+	}
+}
 
-			// Get relative velocity
-			Vec2f relVel = bodyB->velocity - bodyA->velocity;
+// NOTE(final): First impact of the bounds moving by the motion against the tile boxes in the swept bounds.
+//				Seams between boxes are skipped like in the tile contacts, so sliding along the tiles never stops at a seam.
+external TOIResult PhysicsTilesFirstImpact(const PhysicsTileMap *tileMap, const Vec2f &position, const Vec2f &sweepRadius, const Vec2f &motion) {
+	TOIResult result = {};
+	if (tileMap->solidCount == 0) {
+		return(result);
+	}
+	AABB sweptBounds = AABBCombine(AABBFromCenterExt(position, sweepRadius), AABBFromCenterExt(position + motion, sweepRadius));
+	PhysicsTileBoxIterator boxIterator = PhysicsTileBoxIteratorBegin(tileMap, sweptBounds);
+	for (U32 boxIndex = PhysicsTileBoxIteratorNext(&boxIterator); boxIndex != PHYSICS_TILE_NULL_BOX; boxIndex = PhysicsTileBoxIteratorNext(&boxIterator)) {
+		const PhysicsTileBox *box = tileMap->boxes + boxIndex;
+		AABB boxBounds = PhysicsTileMapBoxBounds(tileMap, box);
+		Vec2f boxRadius = (boxBounds.max - boxBounds.min) * 0.5f;
+		TOIResult impact = SweepAABB(position, sweepRadius, motion, boxBounds.min + boxRadius, boxRadius);
+		if (!impact.hit || (result.hit && impact.time >= result.time)) {
+			continue;
+		}
+		// NOTE(final): The normal points into the box, so the face is the opposite edge normal
+		S32 faceIndex;
+		if (impact.normal.x != 0) {
+			faceIndex = impact.normal.x > 0 ? 1 : 3;
+		} else {
+			faceIndex = impact.normal.y > 0 ? 0 : 2;
+		}
+		if (PhysicsTileBoxFaceIsInternal(tileMap, box, faceIndex, position + motion * impact.time)) {
+			continue;
+		}
+		result = impact;
+	}
+	return(result);
+}
 
-			// Calculate mass ratio
-			F32 invMassA = contact->bodyA->type == BodyType::BodyType_Dynamic ? contact->bodyA->invMass : 0;
-			F32 invMassB = contact->bodyB->type == BodyType::BodyType_Dynamic ? contact->bodyB->invMass : 0;
-			F32 massRatio = 1.0f / (invMassA + invMassB);
+// NOTE(final): First impact of the bullet moving by the motion, against the tile boxes in its swept bounds and against its targets.
+//				The targets rest at their integrated position. The tiles are swept with the bounds like in the tile contacts,
+//				which are extended by the slop, so the bullet stops before it touches a tile.
+internal TOIResult PhysicsBulletFirstImpact(Physics *physics, const PhysicsBullet *bullet, const Vec2f &position, const Vec2f &motion) {
+	TOIResult result = {};
+	PhysicsBodyData *bodyData = &physics->bodyData;
+	Body *body = physics->bodies[bullet->bodyIndex];
+	Vec2f radius = bodyData->radii[bullet->bodyIndex];
 
-			// Calculate impulse
-			F32 remove = Vec2Dot(relVel, contact->normal) + contact->distance / input->deltaTime;
-			F32 impulse = Min(remove * massRatio, 0);
+	if (PhysicsBodiesShouldCollide(physics, body, &physics->tileBody)) {
+		Vec2f sweepRadius = radius + V2(PHYSICS_LINEAR_SLOP, PHYSICS_LINEAR_SLOP);
+		result = PhysicsTilesFirstImpact(&physics->tileMap, position, sweepRadius, motion);
+	}
 
-			// Accumulate impulse
-			F32 newImpulse = Min(impulse + contact->impulse, 0);
-			impulse = newImpulse - contact->impulse;
-			contact->impulse = newImpulse;
+	Transform transform = TransformMult(body->shape.localTransform, TransformMakeTranslation(position));
+	AABB sweptBounds = AABBCombine(AABBFromCenterExt(position, radius), AABBFromCenterExt(position + motion, radius));
+	for (U32 targetIndex = 0; targetIndex < bullet->targetCount; ++targetIndex) {
+		Body *target = bullet->targets[targetIndex];
+		Vec2f targetPos = bodyData->positions[target->index];
+		if (!IsAABBOverlap(sweptBounds, AABBFromCenterExt(targetPos, bodyData->radii[target->index]))) {
+			continue;
+		}
+		Transform targetTransform = TransformMult(target->shape.localTransform, TransformMakeTranslation(targetPos));
+		TOIResult impact = QueryTOI(&body->shape, transform, motion, &target->shape, targetTransform, PHYSICS_LINEAR_SLOP);
+		if (impact.hit && (!result.hit || impact.time < result.time)) {
+			result = impact;
+		}
+	}
+	return(result);
+}
 
-			// Apply impulses
-			bodyA->velocity += contact->normal * impulse * invMassA;
-			bodyB->velocity -= contact->normal * impulse * invMassB;
+// NOTE(final): Moves every bullet again from its start position, it stops at the first impact and slides along it with the motion which is left.
+//				The velocity into the impact is removed, the contacts of the next step keep the bullet resting on the surface.
+internal void PhysicsBulletsAdvance(Physics *physics) {
+	PhysicsBodyData *bodyData = &physics->bodyData;
+	for (U32 bulletIndex = 0; bulletIndex < physics->bulletCount; ++bulletIndex) {
+		PhysicsBullet *bullet = physics->bullets + bulletIndex;
+		U32 bodyIndex = bullet->bodyIndex;
+		Vec2f position = bullet->start;
+		Vec2f motion = bodyData->positions[bodyIndex] - bullet->start;
+		Vec2f velocity = bodyData->velocities[bodyIndex];
+		for (U32 substepIndex = 0; substepIndex < PHYSICS_MAX_TOI_SUBSTEP_COUNT; ++substepIndex) {
+			TOIResult impact = PhysicsBulletFirstImpact(physics, bullet, position, motion);
+			if (!impact.hit) {
+				position += motion;
+				break;
+			}
+			++physics->stats.bulletHitCount;
+			position += motion * impact.time;
+			motion = motion * (1.0f - impact.time);
+			F32 motionApproach = Vec2Dot(motion, impact.normal);
+			if (motionApproach > 0) {
+				motion -= impact.normal * motionApproach;
+			}
+			F32 velocityApproach = Vec2Dot(velocity, impact.normal);
+			if (velocityApproach > 0) {
+				velocity -= impact.normal * velocityApproach;
+			}
 		}
+		bodyData->positions[bodyIndex] = position;
+		bodyData->velocities[bodyIndex] = velocity;
 	}
+}
+
+constant U32 PHYSICS_SENSOR_NULL = 0xFFFFFFFF;
+
+// NOTE(final): Sensor and visitor of a pair, which is an overlap of the last step, a candidate pair of this step or both
+struct PhysicsSensorEntry {
+	PhysicsSensorOverlap overlap;
+	U64 key;
+	B32 wasOverlapping;
+	B32 isCandidate;
+	U32 hashNext;
+};
+
+inline U32 PhysicsSensorHash(U64 key, U32 hashMask) {
+	U32 result = (U32)((key * 0x9E3779B97F4A7C15ULL) >> 32) & hashMask;
+	return(result);
+}
+
+// NOTE(final): Returns the entry for the sensor and the visitor, which is appended when it is not found
+internal PhysicsSensorEntry *PhysicsSensorEntryGet(PhysicsSensorEntry *entries, U32 *entryCount, U32 *hashTable, U32 hashMask, Body *sensor, Body *visitor) {
+	U64 key = PhysicsPairKeyMake(sensor->bodyId, visitor->bodyId);
+	U32 hash = PhysicsSensorHash(key, hashMask);
+	for (U32 entryIndex = hashTable[hash]; entryIndex != PHYSICS_SENSOR_NULL; entryIndex = entries[entryIndex].hashNext) {
+		if (entries[entryIndex].key == key) {
+			return(entries + entryIndex);
+		}
+	}
+	U32 entryIndex = (*entryCount)++;
+	PhysicsSensorEntry *result = entries + entryIndex;
+	*result = {};
+	result->overlap.sensor = sensor;
+	result->overlap.visitor = visitor;
+	result->key = key;
+	result->hashNext = hashTable[hash];
+	hashTable[hash] = entryIndex;
+	return(result);
+}
+
+inline void PhysicsSensorEventAdd(Physics *physics, PhysicsSensorEventType type, const PhysicsSensorOverlap &overlap) {
+	if (physics->sensorEventCount < PHYSICS_MAX_SENSOR_EVENT_COUNT) {
+		PhysicsSensorEvent *event = physics->sensorEvents + physics->sensorEventCount++;
+		event->type = type;
+		event->sensor = PhysicsBodyHandleGet(physics, overlap.sensor);
+		event->visitor = PhysicsBodyHandleGet(physics, overlap.visitor);
+		event->sensorUserData = overlap.sensor->userData;
+		event->visitorUserData = overlap.visitor->userData;
+	} else {
+		++physics->sensorEventOverflowCount;
+	}
+}
+
+// NOTE(final): Merges the overlaps of the last step with the sensor pairs of this step and tests their bounds at the integrated positions.
+//				The broadphase does not report pairs of two bodies which are not awake, so the overlaps of the last step are tested even without a candidate pair.
+//				The overlaps of the last step come first and the new pairs follow in pair order, so the events are in the same order on every run.
+internal void PhysicsSensorsUpdate(Physics *physics) {
+	physics->stats.sensorPairCount = physics->sensorPairCount;
+	U32 maxEntryCount = physics->sensorOverlapCount + physics->sensorPairCount;
+	if (maxEntryCount == 0) {
+		return;
+	}
+
+	TemporaryMemory tempMemory = TemporaryMemoryBegin(&physics->physicsMemory);
+	PhysicsSensorEntry *entries = PushArray(&physics->physicsMemory, PhysicsSensorEntry, maxEntryCount, MemoryFlag::MemoryFlag_None);
+	U32 entryCount = 0;
+	// NOTE(final): Must be a power of two, with at least twice as many entries as pairs
+	U32 hashCount = 16;
+	while (hashCount < 2 * maxEntryCount) {
+		hashCount <<= 1;
+	}
+	U32 hashMask = hashCount - 1;
+	U32 *hashTable = PushArray(&physics->physicsMemory, U32, hashCount, MemoryFlag::MemoryFlag_None);
+	for (U32 hashIndex = 0; hashIndex < hashCount; ++hashIndex) {
+		hashTable[hashIndex] = PHYSICS_SENSOR_NULL;
+	}
+	for (U32 overlapIndex = 0; overlapIndex < physics->sensorOverlapCount; ++overlapIndex) {
+		const PhysicsSensorOverlap *overlap = physics->sensorOverlaps + overlapIndex;
+		PhysicsSensorEntry *entry = PhysicsSensorEntryGet(entries, &entryCount, hashTable, hashMask, overlap->sensor, overlap->visitor);
+		entry->wasOverlapping = true;
+	}
+	for (U32 pairIndex = 0; pairIndex < physics->sensorPairCount; ++pairIndex) {
+		const PhysicsPair *pair = physics->sensorPairs + pairIndex;
+		PhysicsSensorEntry *entry = PhysicsSensorEntryGet(entries, &entryCount, hashTable, hashMask, pair->bodyA, pair->bodyB);
+		entry->isCandidate = true;
+	}
+
+	const PhysicsBodyData *bodyData = &physics->bodyData;
+	physics->sensorOverlapCount = 0;
+	for (U32 entryIndex = 0; entryIndex < entryCount; ++entryIndex) {
+		PhysicsSensorEntry *entry = entries + entryIndex;
+		Body *sensor = entry->overlap.sensor;
+		Body *visitor = entry->overlap.visitor;
+		// NOTE(final): Overlaps without a candidate pair must be checked again, the sensor flag or the filters may have been changed
+		B32 isOverlapping = entry->isCandidate || (PhysicsBodyIsSensor(physics, sensor) && !PhysicsBodyIsSensor(physics, visitor) && PhysicsBodiesShouldCollide(physics, sensor, visitor));
+		if (isOverlapping) {
+			AABB sensorBounds = AABBFromCenterExt(bodyData->positions[sensor->index], bodyData->radii[sensor->index]);
+			AABB visitorBounds = AABBFromCenterExt(bodyData->positions[visitor->index], bodyData->radii[visitor->index]);
+			isOverlapping = AABBOverlap(sensorBounds, visitorBounds);
+		}
+		if (isOverlapping) {
+			Assert(physics->sensorOverlapCount < PHYSICS_MAX_SENSOR_OVERLAP_COUNT);
+			if (physics->sensorOverlapCount == PHYSICS_MAX_SENSOR_OVERLAP_COUNT) {
+				continue;
+			}
+			physics->sensorOverlaps[physics->sensorOverlapCount++] = entry->overlap;
+			if (!entry->wasOverlapping) {
+				PhysicsSensorEventAdd(physics, PhysicsSensorEventType::PhysicsSensorEventType_Begin, entry->overlap);
+			}
+		} else if (entry->wasOverlapping) {
+			PhysicsSensorEventAdd(physics, PhysicsSensorEventType::PhysicsSensorEventType_End, entry->overlap);
+		}
+	}
+	physics->stats.sensorOverlapCount = physics->sensorOverlapCount;
+	TemporaryMemoryEnd(&tempMemory);
+}
+
+// NOTE(final): Adds the frame time to the accumulator and returns the number of steps to simulate for this frame.
+//				The interpolation alpha is computed from the time which is left after these steps.
+//				The sensor events of the last frame are cleared, so the events of all steps of this frame are collected.
+external U32 PhysicsFrameBegin(Physics *physics, F32 frameDeltaTime) {
+	Assert(physics->stepDeltaTime > 0);
+	physics->sensorEventCount = 0;
+	physics->sensorEventOverflowCount = 0;
+	physics->stepAccumulator += frameDeltaTime;
+	U32 result = 0;
+	while (physics->stepAccumulator >= physics->stepDeltaTime && result < physics->maxStepCount) {
+		physics->stepAccumulator -= physics->stepDeltaTime;
+		++result;
+	}
+	if (physics->stepAccumulator >= physics->stepDeltaTime) {
+		physics->stepAccumulator = 0;
+	}
+	physics->interpolationAlpha = physics->stepAccumulator / physics->stepDeltaTime;
+	return(result);
+}
+
+external void PhysicsStep(Physics *physics)
+{
+	F32 deltaTime = physics->stepDeltaTime;
+
+	physics->stats = {};
+
+	if (physics->pendingRemovedCount > 0) {
+		PhysicsBodiesRemovedFlush(physics);
+	}
+
+	PhysicsBodyData *bodyData = &physics->bodyData;
 
-	// Integrate velocity
 	for (U32 bodyIndex = 0; bodyIndex < physics->bodyCount; ++bodyIndex) {
-		Body *body = physics->bodies[bodyIndex];
-		if (body->type == BodyType::BodyType_Dynamic) {
-			body->position += body->velocity * input->deltaTime;
+		bodyData->prevPositions[bodyIndex] = bodyData->positions[bodyIndex];
+	}
+
+	// NOTE(final): A sleeping body with a velocity has been changed from outside and wakes up
+	for (U32 bodyIndex = 0; bodyIndex < physics->bodyCount; ++bodyIndex) {
+		U32 flags = bodyData->flags[bodyIndex];
+		if (flags & PHYSICS_BODY_FLAG_DYNAMIC) {
+			if (!(flags & PHYSICS_BODY_FLAG_AWAKE)) {
+				if (Vec2LengthSquared(bodyData->velocities[bodyIndex]) == 0) {
+					continue;
+				}
+				PhysicsBodyWake(physics, physics->bodies[bodyIndex]);
+			}
+			++physics->stats.awakeBodyCount;
 		}
 	}
+
+	// NOTE(final): Integrate acceleration and update bounds
+	PhysicsIntegrateJobsRun(physics, PhysicsIntegrateGravityJob, deltaTime);
+
+	// NOTE(final): Find candidate pairs
+	physics->pairCount = 0;
+	physics->sensorPairCount = 0;
+	PhysicsBroadphaseFindPairs(physics);
+	physics->stats.pairCount = physics->pairCount;
+
+	// NOTE(final): Create contacts
+	PhysicsContactsSwap(physics);
+	PhysicsContactJobsRun(physics);
+	PhysicsContactsMerge(physics);
+	physics->stats.contactCount = physics->contactCount;
+
+	// NOTE(final): Awake bodies touching a sleeping body wake up its island
+	for (U32 contactIndex = 0; contactIndex < physics->contactCount; ++contactIndex) {
+		Contact *contact = physics->contacts + contactIndex;
+		if (PhysicsBodyIsAwake(physics, contact->bodyA)) {
+			PhysicsBodyWake(physics, contact->bodyB);
+		} else if (PhysicsBodyIsAwake(physics, contact->bodyB)) {
+			PhysicsBodyWake(physics, contact->bodyA);
+		}
+	}
+
+	PhysicsBulletsBegin(physics);
+
+	PhysicsSolverPrepare(physics);
+	PhysicsContactsWarmStart(physics);
+
+	// Solve contacts
+	PhysicsIslandsBuild(physics);
+	physics->stats.islandCount = physics->islandCount;
+	switch (physics->solver.type) {
+		case PhysicsSolverType::PhysicsSolverType_Scalar:
+		{
+			for (U32 islandIndex = 0; islandIndex < physics->islandCount; ++islandIndex) {
+				PhysicsIslandSolve(physics, physics->islands + islandIndex, deltaTime);
+			}
+		}; break;
+		case PhysicsSolverType::PhysicsSolverType_ColoredSIMD:
+		{
+			PhysicsSolverColor(physics, &physics->solver, PhysicsStepMemoryGet(physics));
+			physics->stats.solverColorCount = physics->solver.colorCount;
+			physics->stats.solverBatchCount = physics->solver.batchCount;
+			PhysicsSolverSolveColored(physics, &physics->solver, deltaTime);
+		}; break;
+		InvalidDefaultCase;
+	}
+
+	// Integrate velocity
+	PhysicsIntegrateJobsRun(physics, PhysicsIntegrateVelocityJob, deltaTime);
+
+	// NOTE(final): Sweep the bullets from their start positions, so they stop at the first impact
+	PhysicsBulletsAdvance(physics);
+
+	// NOTE(final): Sensor overlaps are tested at the final positions of this step
+	PhysicsSensorsUpdate(physics);
+
+	for (U32 islandIndex = 0; islandIndex < physics->islandCount; ++islandIndex) {
+		PhysicsIslandSleep(physics, physics->islands + islandIndex, deltaTime);
+	}
+}
+
+// NOTE(final): Simulates the frame time in fixed steps, for callers which do not change the bodies between the steps
+external U32 PhysicsUpdate(Physics *physics, InputState *input) {
+	U32 result = PhysicsFrameBegin(physics, input->deltaTime);
+	for (U32 stepIndex = 0; stepIndex < result; ++stepIndex) {
+		PhysicsStep(physics);
+	}
+	return(result);
 }
\ No newline at end of file
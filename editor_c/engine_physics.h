@@ -3,8 +3,15 @@
 #include "engine_types.h"
 #include "engine_math.h"
 #include "engine_memory.h"
-#include "engine_list.h"
 #include "engine_input.h"
+#include "engine_jobs.h"
+
+#include "engine_physics_contact.h"
+#include "engine_physics_shapes.h"
+#include "engine_physics_collision.h"
+#include "engine_physics_broadphase.h"
+#include "engine_physics_tilemap.h"
+#include "engine_physics_solver.h"
 
 enum BodyType {
 	BodyType_Static = 0,
@@ -13,52 +20,428 @@ enum BodyType {
 	BodyType_Count,
 };
 
-struct Body : LinkedListItem {
-	U32 bodyId;
-	BodyType type;
+// NOTE(final): Two bodies collide when the category of each body is in the mask of the other body.
+//				Bodies sharing a non-zero group always collide when the group is positive and never when it is negative, the bits are not checked then.
+struct PhysicsFilter {
+	U32 categoryBits;
+	U32 maskBits;
+	S32 groupIndex;
+};
 
-	Vec2f radius;
+constant U32 PHYSICS_FILTER_DEFAULT_CATEGORY = 1 << 0;
+constant U32 PHYSICS_FILTER_ALL_BITS = 0xFFFFFFFF;
 
-	Vec2f position;
-	Vec2f velocity;
-	F32 invMass;
+inline PhysicsFilter PhysicsFilterMake(U32 categoryBits = PHYSICS_FILTER_DEFAULT_CATEGORY, U32 maskBits = PHYSICS_FILTER_ALL_BITS, S32 groupIndex = 0) {
+	PhysicsFilter result;
+	result.categoryBits = categoryBits;
+	result.maskBits = maskBits;
+	result.groupIndex = groupIndex;
+	return(result);
+}
+
+inline B32 PhysicsFilterShouldCollide(const PhysicsFilter &a, const PhysicsFilter &b) {
+	if (a.groupIndex != 0 && a.groupIndex == b.groupIndex) {
+		B32 result = a.groupIndex > 0;
+		return(result);
+	}
+	B32 result = (a.categoryBits & b.maskBits) != 0 && (b.categoryBits & a.maskBits) != 0;
+	return(result);
+}
+
+// NOTE(final): Cold body data, the simulation state is stored in the physics body data at the dense body index.
+//				The body itself never moves in the body pool, so body pointers are valid until the body is removed.
+struct Body {
+	U32 bodyId;
+	BodyType type;
+	// NOTE(final): Increased when the body is removed, so handles to the removed body are detected
+	U32 generation;
+	U32 nextFree;
+	// NOTE(final): Dense index into the body data, changes when another body is removed
+	U32 index;
 
 	AABB aabb;
+	PhysicsFilter filter;
+	// NOTE(final): Tree leaf or sweep and prune proxy, depending on the broadphase type
+	U32 proxyId;
+
+	F32 sleepTime;
+	// NOTE(final): Dense body index in the current step, used as union-find index
+	U32 islandIndex;
+	// NOTE(final): Circular list of all bodies in the same sleeping island, so all of them are woken together
+	Body *sleepNext;
 
 	void* userData;
+
+	// NOTE(final): Shape in body space, the radius in the body data are the half extents of its bounds
+	Shape shape;
+};
+
+// NOTE(final): Pool slot and generation of a body, a null handle has a generation of zero
+struct BodyHandle {
+	U32 slot;
+	U32 generation;
+};
+
+constant U32 PHYSICS_BODY_NULL_SLOT = 0xFFFFFFFF;
+
+constant U32 PHYSICS_BODY_FLAG_DYNAMIC = 1 << 0;
+// NOTE(final): Dynamic bodies only. Sleeping bodies are not integrated, solved or searched for pairs
+constant U32 PHYSICS_BODY_FLAG_AWAKE = 1 << 1;
+// NOTE(final): Set while the body is being removed only
+constant U32 PHYSICS_BODY_FLAG_REMOVED = 1 << 2;
+// NOTE(final): Dynamic bodies only. Bullets are swept against the tiles and the other bodies, so fast bodies do not tunnel through them
+constant U32 PHYSICS_BODY_FLAG_BULLET = 1 << 3;
+// NOTE(final): Sensors report begin and end overlap events only, their pairs never get any contacts.
+//				Sensors do not collide with the tiles and do not detect other sensors.
+constant U32 PHYSICS_BODY_FLAG_SENSOR = 1 << 4;
+
+// NOTE(final): Everything required to create a body, used for creating many bodies at once
+struct BodyDesc {
+	BodyType type;
+	Vec2f radius;
+	Vec2f position;
+	F32 density;
+	void *userData;
+	// NOTE(final): Optional, when null the body is a box with the radius as its extend. Otherwise the radius is computed from the shape bounds.
+	const Shape *shape;
+	B32 isBullet;
+	B32 isSensor;
+	// NOTE(final): Optional, when null the body collides with everything
+	const PhysicsFilter *filter;
 };
 
-struct Contact {
-	Body *bodyA;
-	Body *bodyB;
-	Vec2f normal;
-	F32 distance;
-	F32 impulse;
+// NOTE(final): Hot simulation state of all bodies in SoA layout, indexed by the dense body index.
+//				Removing a body moves the last body into its slot, so the range [0, bodyCount) has no holes.
+struct PhysicsBodyData {
+	Vec2f *positions;
+	// NOTE(final): Positions before the last step, which are interpolated with the positions for rendering
+	Vec2f *prevPositions;
+	Vec2f *velocities;
+	// NOTE(final): Velocity to push out of penetration, which is applied to the position but never kept
+	Vec2f *biasVelocities;
+	Vec2f *radii;
+	F32 *invMasses;
+	U32 *flags;
 };
 
-constant U32 PHYSICS_MAX_CONTACT_COUNT = 1024;
+// NOTE(final): Bodies connected by contacts, bodies and contacts are stored as index ranges into the island arrays
+struct PhysicsIsland {
+	U32 bodyStart;
+	U32 bodyCount;
+	U32 contactStart;
+	U32 contactCount;
+};
+
+constant U32 PHYSICS_CONTACT_NULL = 0xFFFFFFFF;
+// NOTE(final): Contacts are written into chunks, so a contact buffer grows without moving the contacts written already
+constant U32 PHYSICS_CONTACT_CHUNK_CAPACITY = 256;
+constant U32 PHYSICS_MAX_WORKER_COUNT = JOB_MAX_WORKER_COUNT;
+// NOTE(final): Number of candidate pairs and bodies per job, the body count must be a multiple of four for the SIMD integration
+constant U32 PHYSICS_PAIR_JOB_COUNT = 256;
+constant U32 PHYSICS_TILE_JOB_COUNT = 256;
+constant U32 PHYSICS_INTEGRATE_JOB_COUNT = 1024;
+// NOTE(final): Size of each of the two step memory blocks, which holds the merged contacts and everything stored per contact for one step
+constant memory_size PHYSICS_STEP_MEMORY_SIZE = MegaBytes(8);
+// NOTE(final): Size of the memory for the contact chunks, which is cleared every step after the chunks are merged
+constant memory_size PHYSICS_CONTACT_MEMORY_SIZE = MegaBytes(4);
 constant U32 PHYSICS_MAX_BODY_POOL_COUNT = 10000;
-constant U32 PHYSICS_MAX_SOLVER_ITERATION_COUNT = 4;
+// NOTE(final): The shared tile body is stored after all pool bodies.
+//				The pool count is a multiple of four, so the SIMD kernels never reach the tile body.
+constant U32 PHYSICS_TILE_BODY_INDEX = PHYSICS_MAX_BODY_POOL_COUNT;
+constant U32 PHYSICS_BODY_DATA_COUNT = PHYSICS_MAX_BODY_POOL_COUNT + 1;
+// NOTE(final): Default iteration bounds of the solver, which stops early once no contact changes the relative velocity by more than the tolerance.
+//				The scalar solver checks this per island, the colored solver for all contacts of the step.
+constant U32 PHYSICS_MIN_SOLVER_ITERATION_COUNT = 1;
+constant U32 PHYSICS_MAX_SOLVER_ITERATION_COUNT = 8;
+constant F32 PHYSICS_SOLVER_VELOCITY_TOLERANCE = 0.01f;
+// NOTE(final): Allowed penetration, so resting contacts persist across steps and can be warm started
+constant F32 PHYSICS_LINEAR_SLOP = 0.005f;
+// NOTE(final): Fraction of the penetration which is resolved in one step
+constant F32 PHYSICS_BAUMGARTE_FACTOR = 0.5f;
+constant U32 PHYSICS_MAX_PAIR_COUNT = 4 * PHYSICS_MAX_BODY_POOL_COUNT;
+constant U32 PHYSICS_ISLAND_NULL = 0xFFFFFFFF;
+// NOTE(final): An island goes to sleep when all its bodies are slower than the tolerance for this amount of seconds
+constant F32 PHYSICS_TIME_TO_SLEEP = 0.5f;
+constant F32 PHYSICS_SLEEP_VELOCITY_TOLERANCE = 0.05f;
+// NOTE(final): Gravity is an acceleration in units per second squared and is scaled by the step delta time, so it does not depend on the step rate
+constant F32 PHYSICS_DEFAULT_STEP_RATE = 60.0f;
+// NOTE(final): Time beyond the max steps per frame is dropped, so a long frame slows down the simulation instead of running more and more steps
+constant U32 PHYSICS_DEFAULT_MAX_STEP_COUNT = 4;
+// NOTE(final): Bullets beyond the max count are moved like any other body, bodies beyond the max target count are not swept against
+constant U32 PHYSICS_MAX_BULLET_COUNT = 64;
+constant U32 PHYSICS_MAX_BULLET_TARGET_COUNT = 64;
+// NOTE(final): Number of impacts a bullet slides along in one step, the motion left after the last impact is dropped
+constant U32 PHYSICS_MAX_TOI_SUBSTEP_COUNT = 4;
+// NOTE(final): Sensor pairs and overlaps beyond the max count are dropped, events beyond the max count are dropped and counted
+constant U32 PHYSICS_MAX_SENSOR_PAIR_COUNT = 4096;
+constant U32 PHYSICS_MAX_SENSOR_OVERLAP_COUNT = 4096;
+constant U32 PHYSICS_MAX_SENSOR_EVENT_COUNT = 1024;
+
+struct PhysicsContactChunk {
+	Contact contacts[PHYSICS_CONTACT_CHUNK_CAPACITY];
+	U32 count;
+	PhysicsContactChunk *next;
+};
+
+// NOTE(final): Contacts created by a single worker, the chunks are taken from the shared contact memory without locking.
+//				When the contact memory is used up, new contacts are dropped and counted as overflow.
+struct PhysicsContactBuffer {
+	PhysicsContactChunk *firstChunk;
+	PhysicsContactChunk *lastChunk;
+	U32 contactCount;
+	U32 overflowCount;
+	U32 tileBoxesTested;
+};
+
+// NOTE(final): Contacts written by a single job, which are stored in order starting at the chunk index.
+//				The chunk is null when the buffer had no chunk when the job started.
+struct PhysicsContactRange {
+	PhysicsContactBuffer *buffer;
+	PhysicsContactChunk *chunk;
+	U32 chunkIndex;
+	U32 contactCount;
+};
+
+// NOTE(final): Bullet body with its position at the start of the step and the bodies of its candidate pairs
+struct PhysicsBullet {
+	U32 bodyIndex;
+	Vec2f start;
+	Body *targets[PHYSICS_MAX_BULLET_TARGET_COUNT];
+	U32 targetCount;
+};
+
+// NOTE(final): Overlap between a sensor and a body which is not a sensor
+struct PhysicsSensorOverlap {
+	Body *sensor;
+	Body *visitor;
+};
+
+enum PhysicsSensorEventType {
+	PhysicsSensorEventType_Begin = 0,
+	PhysicsSensorEventType_End,
+
+	PhysicsSensorEventType_Count,
+};
+
+// NOTE(final): The handles may be stale when one of the bodies is removed, the user data are copied when the event is created
+struct PhysicsSensorEvent {
+	PhysicsSensorEventType type;
+	BodyHandle sensor;
+	BodyHandle visitor;
+	void *sensorUserData;
+	void *visitorUserData;
+};
+
+struct Physics;
+
+// NOTE(final): Game specific rules for pairs which pass the filter bits, return false to drop the pair before any contact is created.
+//				Called with the tile body for the tiles, which happens on the job threads.
+#define PHYSICS_PAIR_FILTER(name) B32 name(Physics *physics, Body *bodyA, Body *bodyB, void *userData)
+typedef PHYSICS_PAIR_FILTER(physics_pair_filter);
 
 struct Physics {
 	MemoryBlock physicsMemory;
+	// NOTE(final): Optional, without the platform jobs everything runs on the calling thread
+	PlatformJobs *jobs;
 
-	Contact contacts[PHYSICS_MAX_CONTACT_COUNT];
+	// NOTE(final): The step memory blocks are swapped every step, so the contacts of the previous step are kept until the next step is done.
+	//				The previous contacts are hashed by key and feature, so matching contacts can be warm started.
+	MemoryBlock stepMemory[2];
+	U32 stepIndex;
+	Contact *contacts;
 	U32 contactCount;
+	Contact *prevContacts;
+	U32 prevContactCount;
+	U32 *contactHashTable;
+	U32 *contactHashNext;
+	U32 contactHashMask;
+
+	// NOTE(final): Each worker writes into its own contact buffer, the contact ranges of the jobs are merged into the contacts in job order
+	MemoryBlock contactMemory;
+	volatile U64 contactMemoryUsed;
+	PhysicsContactBuffer contactBuffers[PHYSICS_MAX_WORKER_COUNT];
+	PhysicsContactRange *contactRanges;
+	U32 contactRangeCount;
 
 	U32 bodyIdCounter;
+	// NOTE(final): Slots are used up in order first, removed slots are reused by the free list
 	Body *bodiesBase;
-	LinkedList<Body> bodyPool;
-	LinkedList<Body> usedBodies;
-	Body *bodies[PHYSICS_MAX_BODY_POOL_COUNT];
+	U32 bodySlotCount;
+	U32 freeBodySlot;
+	// NOTE(final): Slots released since the last step. The contacts and sensor overlaps of the last step still point at these slots,
+	//				so the partners are woken up and the overlaps are dropped once at the start of the next step.
+	U8 *removedSlots;
+	U32 *pendingRemovedSlots;
+	U32 pendingRemovedCount;
+	PhysicsBodyData bodyData;
+	Body *bodies[PHYSICS_BODY_DATA_COUNT];
 	U32 bodyCount;
 
+	PhysicsBroadphaseType broadphaseType;
+	PhysicsGrid grid;
+	PhysicsTree tree;
+	PhysicsSAP sap;
+	PhysicsPair *pairs;
+	U32 pairCount;
+
+	U32 *islandParents;
+	U32 *islandIds;
+	PhysicsIsland *islands;
+	U32 islandCount;
+	U32 *islandBodies;
+	// NOTE(final): Taken from the step memory
+	U32 *islandContacts;
+
+	PhysicsBullet *bullets;
+	U32 bulletCount;
+
+	// NOTE(final): Candidate pairs with a sensor, which are tested for overlap at the end of the step
+	PhysicsPair *sensorPairs;
+	U32 sensorPairCount;
+	// NOTE(final): Overlaps at the end of the last step
+	PhysicsSensorOverlap *sensorOverlaps;
+	U32 sensorOverlapCount;
+	// NOTE(final): Events of all steps since the frame began, in step order
+	PhysicsSensorEvent *sensorEvents;
+	U32 sensorEventCount;
+	U32 sensorEventOverflowCount;
+
+	PhysicsSolver solver;
+
+	// NOTE(final): Optional
+	physics_pair_filter *pairFilter;
+	void *pairFilterData;
+
+	PhysicsTileMap tileMap;
+	// NOTE(final): The filter of the tile body is used for all tiles
+	Body tileBody;
+
+	PhysicsStats stats;
+
+	// NOTE(final): Acceleration in units per second squared
 	Vec2f gravity;
+
+	// NOTE(final): The frame time is accumulated and simulated in steps of a fixed delta time, independent of the frame rate.
+	//				The time left in the accumulator is the fraction of a step the positions are interpolated by.
+	F32 stepDeltaTime;
+	U32 maxStepCount;
+	F32 stepAccumulator;
+	F32 interpolationAlpha;
 };
 
-external void PhysicsInit(Physics *physics, const Vec2f &gravity);
-external void PhysicsUpdate(Physics *physics, InputState *input);
+inline MemoryBlock *PhysicsStepMemoryGet(Physics *physics) {
+	MemoryBlock *result = physics->stepMemory + physics->stepIndex;
+	return(result);
+}
+
+inline B32 PhysicsBodyIsAwake(const Physics *physics, const Body *body) {
+	B32 result = (physics->bodyData.flags[body->index] & PHYSICS_BODY_FLAG_AWAKE) != 0;
+	return(result);
+}
+
+// NOTE(final): Returns null when the handle is null or the body has been removed
+inline Body *PhysicsBodyGet(Physics *physics, const BodyHandle &handle) {
+	Body *result = 0;
+	if (handle.slot < physics->bodySlotCount) {
+		Body *body = physics->bodiesBase + handle.slot;
+		if (body->generation == handle.generation) {
+			result = body;
+		}
+	}
+	return(result);
+}
+
+inline BodyHandle PhysicsBodyHandleGet(const Physics *physics, const Body *body) {
+	BodyHandle result = {};
+	result.slot = (U32)(body - physics->bodiesBase);
+	result.generation = body->generation;
+	return(result);
+}
+
+inline Vec2f PhysicsBodyGetPosition(const Physics *physics, const Body *body) {
+	Vec2f result = physics->bodyData.positions[body->index];
+	return(result);
+}
+
+// NOTE(final): Position between the last two steps, at the time of the current frame
+inline Vec2f PhysicsBodyGetInterpolatedPosition(const Physics *physics, const Body *body) {
+	const PhysicsBodyData *bodyData = &physics->bodyData;
+	Vec2f prevPos = bodyData->prevPositions[body->index];
+	Vec2f result = prevPos + (bodyData->positions[body->index] - prevPos) * physics->interpolationAlpha;
+	return(result);
+}
+
+inline Vec2f PhysicsBodyGetVelocity(const Physics *physics, const Body *body) {
+	Vec2f result = physics->bodyData.velocities[body->index];
+	return(result);
+}
+
+inline void PhysicsBodySetVelocity(Physics *physics, Body *body, const Vec2f &velocity) {
+	physics->bodyData.velocities[body->index] = velocity;
+}
+
+inline void PhysicsBodySetBullet(Physics *physics, Body *body, B32 isBullet) {
+	Assert(body->type == BodyType::BodyType_Dynamic);
+	U32 *flags = physics->bodyData.flags + body->index;
+	if (isBullet) {
+		*flags |= PHYSICS_BODY_FLAG_BULLET;
+	} else {
+		*flags &= ~PHYSICS_BODY_FLAG_BULLET;
+	}
+}
+
+// NOTE(final): The overlaps of a body which stops being a sensor end with the next step
+inline void PhysicsBodySetSensor(Physics *physics, Body *body, B32 isSensor) {
+	U32 *flags = physics->bodyData.flags + body->index;
+	if (isSensor) {
+		*flags |= PHYSICS_BODY_FLAG_SENSOR;
+	} else {
+		*flags &= ~PHYSICS_BODY_FLAG_SENSOR;
+	}
+}
+
+inline B32 PhysicsBodyIsSensor(const Physics *physics, const Body *body) {
+	B32 result = (physics->bodyData.flags[body->index] & PHYSICS_BODY_FLAG_SENSOR) != 0;
+	return(result);
+}
+
+inline void PhysicsBodySetFilter(Physics *physics, Body *body, const PhysicsFilter &filter) {
+	body->filter = filter;
+}
+
+inline void PhysicsTileSetFilter(Physics *physics, const PhysicsFilter &filter) {
+	physics->tileBody.filter = filter;
+}
+
+inline B32 PhysicsBodiesShouldCollide(Physics *physics, Body *bodyA, Body *bodyB) {
+	B32 result = PhysicsFilterShouldCollide(bodyA->filter, bodyB->filter);
+	if (result && physics->pairFilter) {
+		result = physics->pairFilter(physics, bodyA, bodyB, physics->pairFilterData);
+	}
+	return(result);
+}
+
+inline Vec2f PhysicsBodyGetRadius(const Physics *physics, const Body *body) {
+	Vec2f result = physics->bodyData.radii[body->index];
+	return(result);
+}
+
+external void PhysicsInit(Physics *physics, const Vec2f &gravity, const Vec2f &tileSize, PhysicsBroadphaseType broadphaseType = PhysicsBroadphaseType_Tree, PhysicsSolverType solverType = PhysicsSolverType_ColoredSIMD);
+external void PhysicsStepRateSet(Physics *physics, F32 stepRate, U32 maxStepCount);
+external U32 PhysicsFrameBegin(Physics *physics, F32 frameDeltaTime);
+external void PhysicsStep(Physics *physics);
+external U32 PhysicsUpdate(Physics *physics, InputState *input);
 external void PhysicsClear(Physics *physics);
 
-external Body *PhysicsBodyCreate(Physics *physics, BodyType type, const Vec2f &radius, const Vec2f &pos, F32 density);
-external void PhysicsBodyRemove(Physics *physics, Body *body);
\ No newline at end of file
+external BodyHandle PhysicsBodyCreate(Physics *physics, BodyType type, const Vec2f &radius, const Vec2f &pos, F32 density);
+external BodyHandle PhysicsBodyCreateShape(Physics *physics, BodyType type, const Shape &shape, const Vec2f &pos, F32 density);
+external B32 PhysicsBodyRemove(Physics *physics, const BodyHandle &handle);
+external U32 PhysicsBodiesCreateBatch(Physics *physics, const BodyDesc *descs, U32 descCount, BodyHandle *outHandles);
+external U32 PhysicsBodiesRemoveBatch(Physics *physics, const BodyHandle *handles, U32 handleCount);
+external void PhysicsBodyWake(Physics *physics, Body *body);
+external void PhysicsTileSet(Physics *physics, S32 tileX, S32 tileY, B32 solid);
+
+external Vec2f PhysicsShapeGetExtents(const Shape &shape);
+external TOIResult PhysicsTilesFirstImpact(const PhysicsTileMap *tileMap, const Vec2f &position, const Vec2f &sweepRadius, const Vec2f &motion);
+
+external void PhysicsSolverSolveScalar(Physics *physics, const U32 *contactIndices, U32 contactCount, F32 deltaTime);
\ No newline at end of file
@@ -0,0 +1,1050 @@
+#include "engine_physics_broadphase.h"
+
+#include "engine_physics.h"
+
+// NOTE(final): The filters are checked here for every broadphase, so filtered pairs never reach the contact generation.
+//				Pairs with a sensor stop here as well, these are tested for overlap at the end of the step only.
+inline void PhysicsPairAdd(Physics *physics, Body *bodyA, Body *bodyB) {
+	B32 isSensorA = PhysicsBodyIsSensor(physics, bodyA);
+	B32 isSensorB = PhysicsBodyIsSensor(physics, bodyB);
+	if (isSensorA && isSensorB) {
+		return;
+	}
+	if (!PhysicsBodiesShouldCollide(physics, bodyA, bodyB)) {
+		++physics->stats.pairsFiltered;
+		return;
+	}
+	if (isSensorA || isSensorB) {
+		Assert(physics->sensorPairCount < PHYSICS_MAX_SENSOR_PAIR_COUNT);
+		if (physics->sensorPairCount < PHYSICS_MAX_SENSOR_PAIR_COUNT) {
+			PhysicsPair *pair = physics->sensorPairs + physics->sensorPairCount++;
+			pair->bodyA = isSensorA ? bodyA : bodyB;
+			pair->bodyB = isSensorA ? bodyB : bodyA;
+		}
+		return;
+	}
+	Assert(physics->pairCount < PHYSICS_MAX_PAIR_COUNT);
+	if (physics->pairCount < PHYSICS_MAX_PAIR_COUNT) {
+		PhysicsPair *pair = physics->pairs + physics->pairCount++;
+		pair->bodyA = bodyA;
+		pair->bodyB = bodyB;
+	}
+}
+
+inline U32 PhysicsGridBucketGet(const Vec2i &cell) {
+	U32 hash = ((U32)cell.x * 73856093) ^ ((U32)cell.y * 19349663);
+	U32 result = hash & (PHYSICS_GRID_BUCKET_COUNT - 1);
+	return(result);
+}
+
+external void PhysicsGridInit(PhysicsGrid *grid, MemoryBlock *memory, const Vec2f &tileSize, U32 maxBodyCount) {
+	Assert(tileSize.x > 0 && tileSize.y > 0);
+	grid->tileSize = tileSize;
+	grid->cellSize = tileSize;
+	grid->bucketStarts = PushArray(memory, U32, PHYSICS_GRID_BUCKET_COUNT + 1);
+	grid->entries = PushArray(memory, PhysicsGridEntry, maxBodyCount);
+	grid->bodyCells = PushArray(memory, Vec2i, maxBodyCount);
+	grid->bodyBuckets = PushArray(memory, U32, maxBodyCount);
+}
+
+external void PhysicsGridFindPairs(Physics *physics, PhysicsGrid *grid) {
+	U32 bodyCount = physics->bodyCount;
+	Body **bodies = physics->bodies;
+
+	// NOTE(final): Grow the cell size in tile steps until the largest body fits into one cell.
+	//				Then two overlapping bodies are always in the same or in neighbouring cells.
+	Vec2f maxSize = grid->tileSize;
+	for (U32 bodyIndex = 0; bodyIndex < bodyCount; ++bodyIndex) {
+		Body *body = bodies[bodyIndex];
+		maxSize = Vec2Max(maxSize, body->aabb.max - body->aabb.min);
+	}
+	grid->cellSize.x = CeilF32ToS32(maxSize.x / grid->tileSize.x) * grid->tileSize.x;
+	grid->cellSize.y = CeilF32ToS32(maxSize.y / grid->tileSize.y) * grid->tileSize.y;
+
+	// NOTE(final): Counting sort of all bodies into the hashed cell buckets
+	U32 *bucketStarts = grid->bucketStarts;
+	ZeroArray(bucketStarts, PHYSICS_GRID_BUCKET_COUNT + 1);
+	for (U32 bodyIndex = 0; bodyIndex < bodyCount; ++bodyIndex) {
+		Body *body = bodies[bodyIndex];
+		Vec2f center = (body->aabb.min + body->aabb.max) * 0.5f;
+		Vec2i cell = V2i(FloorF32ToS32(center.x / grid->cellSize.x), FloorF32ToS32(center.y / grid->cellSize.y));
+		U32 bucket = PhysicsGridBucketGet(cell);
+		grid->bodyCells[bodyIndex] = cell;
+		grid->bodyBuckets[bodyIndex] = bucket;
+		++bucketStarts[bucket + 1];
+	}
+	for (U32 bucketIndex = 0; bucketIndex < PHYSICS_GRID_BUCKET_COUNT; ++bucketIndex) {
+		bucketStarts[bucketIndex + 1] += bucketStarts[bucketIndex];
+	}
+	for (U32 bodyIndex = 0; bodyIndex < bodyCount; ++bodyIndex) {
+		U32 bucket = grid->bodyBuckets[bodyIndex];
+		PhysicsGridEntry *entry = grid->entries + bucketStarts[bucket]++;
+		entry->cell = grid->bodyCells[bodyIndex];
+		entry->bodyIndex = bodyIndex;
+	}
+	// NOTE(final): Scatter has moved every start to the next bucket, shift them back
+	for (U32 bucketIndex = PHYSICS_GRID_BUCKET_COUNT; bucketIndex > 0; --bucketIndex) {
+		bucketStarts[bucketIndex] = bucketStarts[bucketIndex - 1];
+	}
+	bucketStarts[0] = 0;
+
+	// NOTE(final): Only awake bodies are searching, static and sleeping bodies are found by them.
+	//				Awake vs awake is reported once by the lower body index only.
+	for (U32 bodyIndexA = 0; bodyIndexA < bodyCount; ++bodyIndexA) {
+		Body *bodyA = bodies[bodyIndexA];
+		if (!PhysicsBodyIsAwake(physics, bodyA)) {
+			continue;
+		}
+		Vec2i cellA = grid->bodyCells[bodyIndexA];
+		for (S32 offsetY = -1; offsetY <= 1; ++offsetY) {
+			for (S32 offsetX = -1; offsetX <= 1; ++offsetX) {
+				Vec2i cell = V2i(cellA.x + offsetX, cellA.y + offsetY);
+				U32 bucket = PhysicsGridBucketGet(cell);
+				for (U32 entryIndex = bucketStarts[bucket]; entryIndex < bucketStarts[bucket + 1]; ++entryIndex) {
+					PhysicsGridEntry *entry = grid->entries + entryIndex;
+					// NOTE(final): Different cells may share the same bucket
+					if (entry->cell.x != cell.x || entry->cell.y != cell.y) {
+						continue;
+					}
+					Body *bodyB = bodies[entry->bodyIndex];
+					if (PhysicsBodyIsAwake(physics, bodyB) && entry->bodyIndex <= bodyIndexA) {
+						continue;
+					}
+					++physics->stats.pairsTested;
+					if (AABBOverlap(bodyA->aabb, bodyB->aabb)) {
+						PhysicsPairAdd(physics, bodyA, bodyB);
+					}
+				}
+			}
+		}
+	}
+}
+
+//
+// Dynamic AABB tree
+//
+
+external void PhysicsTreeClear(PhysicsTree *tree) {
+	tree->root = PHYSICS_TREE_NULL_NODE;
+	tree->nodeCount = 0;
+	for (U32 nodeIndex = 0; nodeIndex < tree->nodeCapacity; ++nodeIndex) {
+		PhysicsTreeNode *node = tree->nodes + nodeIndex;
+		*node = {};
+		node->parent = (nodeIndex + 1) < tree->nodeCapacity ? nodeIndex + 1 : PHYSICS_TREE_NULL_NODE;
+		node->child1 = node->child2 = PHYSICS_TREE_NULL_NODE;
+		node->height = -1;
+	}
+	tree->freeList = 0;
+}
+
+external void PhysicsTreeInit(PhysicsTree *tree, MemoryBlock *memory, U32 maxBodyCount) {
+	// NOTE(final): A full binary tree with N leafs has N - 1 internal nodes
+	tree->nodeCapacity = maxBodyCount * 2;
+	tree->nodes = PushArray(memory, PhysicsTreeNode, tree->nodeCapacity);
+	PhysicsTreeClear(tree);
+}
+
+internal U32 PhysicsTreeNodeAllocate(PhysicsTree *tree) {
+	Assert(tree->freeList != PHYSICS_TREE_NULL_NODE);
+	U32 result = tree->freeList;
+	PhysicsTreeNode *node = tree->nodes + result;
+	tree->freeList = node->parent;
+	*node = {};
+	node->parent = node->child1 = node->child2 = PHYSICS_TREE_NULL_NODE;
+	node->height = 0;
+	++tree->nodeCount;
+	return(result);
+}
+
+internal void PhysicsTreeNodeFree(PhysicsTree *tree, U32 nodeId) {
+	Assert(tree->nodeCount > 0);
+	PhysicsTreeNode *node = tree->nodes + nodeId;
+	node->parent = tree->freeList;
+	node->height = -1;
+	node->body = 0;
+	tree->freeList = nodeId;
+	--tree->nodeCount;
+}
+
+// NOTE(final): Performs a left or right rotation, when the node is imbalanced. Returns the new root of the sub tree.
+internal U32 PhysicsTreeBalance(PhysicsTree *tree, U32 iA) {
+	PhysicsTreeNode *A = tree->nodes + iA;
+	if (PhysicsTreeNodeIsLeaf(A) || A->height < 2) {
+		return(iA);
+	}
+
+	U32 iB = A->child1;
+	U32 iC = A->child2;
+	PhysicsTreeNode *B = tree->nodes + iB;
+	PhysicsTreeNode *C = tree->nodes + iC;
+	S32 balance = C->height - B->height;
+
+	// NOTE(final): Rotate C up
+	if (balance > 1) {
+		U32 iF = C->child1;
+		U32 iG = C->child2;
+		PhysicsTreeNode *F = tree->nodes + iF;
+		PhysicsTreeNode *G = tree->nodes + iG;
+
+		C->child1 = iA;
+		C->parent = A->parent;
+		A->parent = iC;
+		if (C->parent != PHYSICS_TREE_NULL_NODE) {
+			PhysicsTreeNode *parent = tree->nodes + C->parent;
+			if (parent->child1 == iA) {
+				parent->child1 = iC;
+			} else {
+				parent->child2 = iC;
+			}
+		} else {
+			tree->root = iC;
+		}
+
+		if (F->height > G->height) {
+			C->child2 = iF;
+			A->child2 = iG;
+			G->parent = iA;
+			A->aabb = AABBCombine(B->aabb, G->aabb);
+			C->aabb = AABBCombine(A->aabb, F->aabb);
+			A->height = 1 + Max(B->height, G->height);
+			C->height = 1 + Max(A->height, F->height);
+		} else {
+			C->child2 = iG;
+			A->child2 = iF;
+			F->parent = iA;
+			A->aabb = AABBCombine(B->aabb, F->aabb);
+			C->aabb = AABBCombine(A->aabb, G->aabb);
+			A->height = 1 + Max(B->height, F->height);
+			C->height = 1 + Max(A->height, G->height);
+		}
+		return(iC);
+	}
+
+	// NOTE(final): Rotate B up
+	if (balance < -1) {
+		U32 iD = B->child1;
+		U32 iE = B->child2;
+		PhysicsTreeNode *D = tree->nodes + iD;
+		PhysicsTreeNode *E = tree->nodes + iE;
+
+		B->child1 = iA;
+		B->parent = A->parent;
+		A->parent = iB;
+		if (B->parent != PHYSICS_TREE_NULL_NODE) {
+			PhysicsTreeNode *parent = tree->nodes + B->parent;
+			if (parent->child1 == iA) {
+				parent->child1 = iB;
+			} else {
+				parent->child2 = iB;
+			}
+		} else {
+			tree->root = iB;
+		}
+
+		if (D->height > E->height) {
+			B->child2 = iD;
+			A->child1 = iE;
+			E->parent = iA;
+			A->aabb = AABBCombine(C->aabb, E->aabb);
+			B->aabb = AABBCombine(A->aabb, D->aabb);
+			A->height = 1 + Max(C->height, E->height);
+			B->height = 1 + Max(A->height, D->height);
+		} else {
+			B->child2 = iE;
+			A->child1 = iD;
+			D->parent = iA;
+			A->aabb = AABBCombine(C->aabb, D->aabb);
+			B->aabb = AABBCombine(A->aabb, E->aabb);
+			A->height = 1 + Max(C->height, D->height);
+			B->height = 1 + Max(A->height, E->height);
+		}
+		return(iB);
+	}
+
+	return(iA);
+}
+
+// NOTE(final): Walks up from the given node, refits the bounds and rebalances the tree
+internal void PhysicsTreeRefit(PhysicsTree *tree, U32 nodeId) {
+	while (nodeId != PHYSICS_TREE_NULL_NODE) {
+		nodeId = PhysicsTreeBalance(tree, nodeId);
+		PhysicsTreeNode *node = tree->nodes + nodeId;
+		PhysicsTreeNode *child1 = tree->nodes + node->child1;
+		PhysicsTreeNode *child2 = tree->nodes + node->child2;
+		node->height = 1 + Max(child1->height, child2->height);
+		node->aabb = AABBCombine(child1->aabb, child2->aabb);
+		nodeId = node->parent;
+	}
+}
+
+internal void PhysicsTreeInsertLeaf(PhysicsTree *tree, U32 leaf) {
+	if (tree->root == PHYSICS_TREE_NULL_NODE) {
+		tree->root = leaf;
+		tree->nodes[leaf].parent = PHYSICS_TREE_NULL_NODE;
+		return;
+	}
+
+	// NOTE(final): Find the best sibling by descending the cheapest perimeter increase
+	AABB leafAABB = tree->nodes[leaf].aabb;
+	U32 index = tree->root;
+	while (!PhysicsTreeNodeIsLeaf(tree->nodes + index)) {
+		PhysicsTreeNode *node = tree->nodes + index;
+		PhysicsTreeNode *child1 = tree->nodes + node->child1;
+		PhysicsTreeNode *child2 = tree->nodes + node->child2;
+
+		F32 perimeter = AABBPerimeter(node->aabb);
+		F32 combinedPerimeter = AABBPerimeter(AABBCombine(node->aabb, leafAABB));
+
+		// NOTE(final): Cost of creating a new parent for this node and the leaf
+		F32 cost = 2.0f * combinedPerimeter;
+		// NOTE(final): Minimum cost of pushing the leaf further down the tree
+		F32 inheritanceCost = 2.0f * (combinedPerimeter - perimeter);
+
+		F32 cost1 = AABBPerimeter(AABBCombine(leafAABB, child1->aabb)) + inheritanceCost;
+		if (!PhysicsTreeNodeIsLeaf(child1)) {
+			cost1 -= AABBPerimeter(child1->aabb);
+		}
+		F32 cost2 = AABBPerimeter(AABBCombine(leafAABB, child2->aabb)) + inheritanceCost;
+		if (!PhysicsTreeNodeIsLeaf(child2)) {
+			cost2 -= AABBPerimeter(child2->aabb);
+		}
+
+		if (cost < cost1 && cost < cost2) {
+			break;
+		}
+		index = cost1 < cost2 ? node->child1 : node->child2;
+	}
+
+	// NOTE(final): Create a new parent for the sibling and the leaf
+	U32 sibling = index;
+	U32 oldParent = tree->nodes[sibling].parent;
+	U32 newParent = PhysicsTreeNodeAllocate(tree);
+	PhysicsTreeNode *newParentNode = tree->nodes + newParent;
+	newParentNode->parent = oldParent;
+	newParentNode->aabb = AABBCombine(leafAABB, tree->nodes[sibling].aabb);
+	newParentNode->height = tree->nodes[sibling].height + 1;
+	newParentNode->child1 = sibling;
+	newParentNode->child2 = leaf;
+	tree->nodes[sibling].parent = newParent;
+	tree->nodes[leaf].parent = newParent;
+
+	if (oldParent != PHYSICS_TREE_NULL_NODE) {
+		PhysicsTreeNode *oldParentNode = tree->nodes + oldParent;
+		if (oldParentNode->child1 == sibling) {
+			oldParentNode->child1 = newParent;
+		} else {
+			oldParentNode->child2 = newParent;
+		}
+	} else {
+		tree->root = newParent;
+	}
+
+	PhysicsTreeRefit(tree, tree->nodes[leaf].parent);
+}
+
+internal void PhysicsTreeRemoveLeaf(PhysicsTree *tree, U32 leaf) {
+	if (leaf == tree->root) {
+		tree->root = PHYSICS_TREE_NULL_NODE;
+		return;
+	}
+
+	U32 parent = tree->nodes[leaf].parent;
+	PhysicsTreeNode *parentNode = tree->nodes + parent;
+	U32 grandParent = parentNode->parent;
+	U32 sibling = parentNode->child1 == leaf ? parentNode->child2 : parentNode->child1;
+
+	// NOTE(final): Replace the parent with the sibling
+	if (grandParent != PHYSICS_TREE_NULL_NODE) {
+		PhysicsTreeNode *grandParentNode = tree->nodes + grandParent;
+		if (grandParentNode->child1 == parent) {
+			grandParentNode->child1 = sibling;
+		} else {
+			grandParentNode->child2 = sibling;
+		}
+		tree->nodes[sibling].parent = grandParent;
+		PhysicsTreeNodeFree(tree, parent);
+		PhysicsTreeRefit(tree, grandParent);
+	} else {
+		tree->root = sibling;
+		tree->nodes[sibling].parent = PHYSICS_TREE_NULL_NODE;
+		PhysicsTreeNodeFree(tree, parent);
+	}
+}
+
+inline AABB PhysicsTreeFatten(const AABB &aabb) {
+	AABB result = AABBFromMinMax(aabb.min - V2(PHYSICS_TREE_AABB_MARGIN), aabb.max + V2(PHYSICS_TREE_AABB_MARGIN));
+	return(result);
+}
+
+external U32 PhysicsTreeInsert(PhysicsTree *tree, Body *body, const AABB &aabb) {
+	U32 result = PhysicsTreeNodeAllocate(tree);
+	PhysicsTreeNode *node = tree->nodes + result;
+	node->aabb = PhysicsTreeFatten(aabb);
+	node->body = body;
+	PhysicsTreeInsertLeaf(tree, result);
+	return(result);
+}
+
+external void PhysicsTreeRemove(PhysicsTree *tree, U32 proxyId) {
+	Assert(proxyId < tree->nodeCapacity);
+	Assert(PhysicsTreeNodeIsLeaf(tree->nodes + proxyId));
+	PhysicsTreeRemoveLeaf(tree, proxyId);
+	PhysicsTreeNodeFree(tree, proxyId);
+}
+
+// NOTE(final): Reinserts the leaf only when the new bounds are leaving the fat bounds, returns true when it was reinserted
+external B32 PhysicsTreeMove(PhysicsTree *tree, U32 proxyId, const AABB &aabb) {
+	Assert(proxyId < tree->nodeCapacity);
+	PhysicsTreeNode *node = tree->nodes + proxyId;
+	Assert(PhysicsTreeNodeIsLeaf(node));
+	if (AABBContains(node->aabb, aabb)) {
+		return false;
+	}
+	PhysicsTreeRemoveLeaf(tree, proxyId);
+	node->aabb = PhysicsTreeFatten(aabb);
+	PhysicsTreeInsertLeaf(tree, proxyId);
+	return true;
+}
+
+external void PhysicsTreeFindPairs(Physics *physics, PhysicsTree *tree) {
+	if (tree->root == PHYSICS_TREE_NULL_NODE) {
+		return;
+	}
+
+	U32 stack[PHYSICS_TREE_MAX_STACK_COUNT];
+	for (U32 bodyIndex = 0; bodyIndex < physics->bodyCount; ++bodyIndex) {
+		Body *bodyA = physics->bodies[bodyIndex];
+		if (!PhysicsBodyIsAwake(physics, bodyA)) {
+			continue;
+		}
+
+		U32 stackCount = 0;
+		stack[stackCount++] = tree->root;
+		while (stackCount > 0) {
+			U32 nodeId = stack[--stackCount];
+			PhysicsTreeNode *node = tree->nodes + nodeId;
+			if (!AABBOverlap(node->aabb, bodyA->aabb)) {
+				continue;
+			}
+			if (PhysicsTreeNodeIsLeaf(node)) {
+				Body *bodyB = node->body;
+				// NOTE(final): Awake vs awake is reported once by the lower body id only
+				if (bodyB == bodyA || (PhysicsBodyIsAwake(physics, bodyB) && bodyB->bodyId < bodyA->bodyId)) {
+					continue;
+				}
+				++physics->stats.pairsTested;
+				if (AABBOverlap(bodyA->aabb, bodyB->aabb)) {
+					PhysicsPairAdd(physics, bodyA, bodyB);
+				}
+			} else {
+				Assert(stackCount + 2 <= PHYSICS_TREE_MAX_STACK_COUNT);
+				stack[stackCount++] = node->child1;
+				stack[stackCount++] = node->child2;
+			}
+		}
+	}
+}
+
+//
+// Pair cache
+//
+
+inline U32 PhysicsPairCacheHash(PhysicsPairCache *cache, U64 key) {
+	U32 result = (U32)((key * 0x9E3779B97F4A7C15ULL) >> 32) & cache->hashMask;
+	return(result);
+}
+
+external void PhysicsPairCacheInit(PhysicsPairCache *cache, MemoryBlock *memory, U32 pairCapacity) {
+	// NOTE(final): Twice the pair capacity rounded up to a power of two, keeps the chains short
+	U32 hashCount = 1;
+	while (hashCount < pairCapacity * 2) {
+		hashCount <<= 1;
+	}
+	cache->hashMask = hashCount - 1;
+	cache->hashTable = PushArray(memory, U32, hashCount);
+	cache->nextPair = PushArray(memory, U32, pairCapacity);
+	cache->keys = PushArray(memory, U64, pairCapacity);
+	cache->pairs = PushArray(memory, PhysicsPair, pairCapacity);
+	cache->pairCapacity = pairCapacity;
+	PhysicsPairCacheClear(cache);
+}
+
+external void PhysicsPairCacheClear(PhysicsPairCache *cache) {
+	for (U32 hashIndex = 0; hashIndex <= cache->hashMask; ++hashIndex) {
+		cache->hashTable[hashIndex] = PHYSICS_PAIR_CACHE_NULL;
+	}
+	cache->pairCount = 0;
+}
+
+external PhysicsPair *PhysicsPairCacheFind(PhysicsPairCache *cache, U64 key) {
+	U32 hash = PhysicsPairCacheHash(cache, key);
+	for (U32 pairIndex = cache->hashTable[hash]; pairIndex != PHYSICS_PAIR_CACHE_NULL; pairIndex = cache->nextPair[pairIndex]) {
+		if (cache->keys[pairIndex] == key) {
+			return(cache->pairs + pairIndex);
+		}
+	}
+	return(0);
+}
+
+external PhysicsPair *PhysicsPairCacheAdd(PhysicsPairCache *cache, U64 key, Body *bodyA, Body *bodyB) {
+	PhysicsPair *result = PhysicsPairCacheFind(cache, key);
+	if (!result) {
+		Assert(cache->pairCount < cache->pairCapacity);
+		if (cache->pairCount < cache->pairCapacity) {
+			U32 hash = PhysicsPairCacheHash(cache, key);
+			U32 pairIndex = cache->pairCount++;
+			cache->keys[pairIndex] = key;
+			cache->nextPair[pairIndex] = cache->hashTable[hash];
+			cache->hashTable[hash] = pairIndex;
+			result = cache->pairs + pairIndex;
+			result->bodyA = bodyA;
+			result->bodyB = bodyB;
+		}
+	}
+	return(result);
+}
+
+// NOTE(final): Unlinks the pair from its hash chain, but keeps the dense storage as-is
+internal void PhysicsPairCacheUnlink(PhysicsPairCache *cache, U32 hash, U32 pairIndex) {
+	U32 *link = cache->hashTable + hash;
+	while (*link != pairIndex) {
+		Assert(*link != PHYSICS_PAIR_CACHE_NULL);
+		link = cache->nextPair + *link;
+	}
+	*link = cache->nextPair[pairIndex];
+}
+
+external B32 PhysicsPairCacheRemove(PhysicsPairCache *cache, U64 key) {
+	PhysicsPair *pair = PhysicsPairCacheFind(cache, key);
+	if (!pair) {
+		return false;
+	}
+	U32 pairIndex = (U32)(pair - cache->pairs);
+	PhysicsPairCacheUnlink(cache, PhysicsPairCacheHash(cache, key), pairIndex);
+
+	// NOTE(final): Keep the pairs dense by moving the last pair into the hole
+	U32 lastIndex = cache->pairCount - 1;
+	if (pairIndex != lastIndex) {
+		U64 lastKey = cache->keys[lastIndex];
+		U32 lastHash = PhysicsPairCacheHash(cache, lastKey);
+		PhysicsPairCacheUnlink(cache, lastHash, lastIndex);
+		cache->keys[pairIndex] = lastKey;
+		cache->pairs[pairIndex] = cache->pairs[lastIndex];
+		cache->nextPair[pairIndex] = cache->hashTable[lastHash];
+		cache->hashTable[lastHash] = pairIndex;
+	}
+	--cache->pairCount;
+	return true;
+}
+
+//
+// Sweep and prune
+//
+
+inline B32 PhysicsSAPEndpointIsMax(const PhysicsSAPEndpoint &endpoint) {
+	B32 result = endpoint.data & 1;
+	return(result);
+}
+
+inline U32 PhysicsSAPEndpointProxy(const PhysicsSAPEndpoint &endpoint) {
+	U32 result = endpoint.data >> 1;
+	return(result);
+}
+
+// NOTE(final): On equal values a min endpoint is sorted before a max endpoint, so touching bounds are overlapping
+inline B32 PhysicsSAPEndpointLess(const PhysicsSAPEndpoint &a, const PhysicsSAPEndpoint &b) {
+	B32 result = (a.value < b.value) || (a.value == b.value && (a.data & 1) < (b.data & 1));
+	return(result);
+}
+
+external void PhysicsSAPClear(PhysicsSAP *sap) {
+	sap->endpointCount = 0;
+	sap->proxyCount = 0;
+	sap->freeProxy = PHYSICS_BROADPHASE_NULL_PROXY;
+	PhysicsPairCacheClear(&sap->pairCache);
+}
+
+external void PhysicsSAPInit(PhysicsSAP *sap, MemoryBlock *memory, U32 maxBodyCount, U32 maxPairCount) {
+	sap->proxyCapacity = maxBodyCount;
+	sap->proxies = PushArray(memory, PhysicsSAPProxy, maxBodyCount);
+	sap->endpoints[0] = PushArray(memory, PhysicsSAPEndpoint, maxBodyCount * 2);
+	sap->endpoints[1] = PushArray(memory, PhysicsSAPEndpoint, maxBodyCount * 2);
+	PhysicsPairCacheInit(&sap->pairCache, memory, maxPairCount);
+	PhysicsSAPClear(sap);
+}
+
+// NOTE(final): Two endpoints of different proxies have been swapped, which may begin or end an overlap
+internal void PhysicsSAPEndpointsSwapped(Physics *physics, PhysicsSAP *sap, U32 proxyIndexA, U32 proxyIndexB, B32 beginOverlap) {
+	if (proxyIndexA == proxyIndexB) {
+		return;
+	}
+	PhysicsSAPProxy *proxyA = sap->proxies + proxyIndexA;
+	PhysicsSAPProxy *proxyB = sap->proxies + proxyIndexB;
+	Body *bodyA = proxyA->body;
+	Body *bodyB = proxyB->body;
+	U64 key = PhysicsPairKeyMake(bodyA->bodyId, bodyB->bodyId);
+	if (beginOverlap) {
+		if (bodyA->type == BodyType::BodyType_Dynamic || bodyB->type == BodyType::BodyType_Dynamic) {
+			++physics->stats.pairsTested;
+			if (AABBOverlap(proxyA->aabb, proxyB->aabb)) {
+				PhysicsPairCacheAdd(&sap->pairCache, key, bodyA, bodyB);
+			}
+		}
+	} else {
+		PhysicsPairCacheRemove(&sap->pairCache, key);
+	}
+}
+
+inline void PhysicsSAPEndpointSwap(PhysicsSAP *sap, U32 axis, U32 indexA, U32 indexB) {
+	PhysicsSAPEndpoint *endpoints = sap->endpoints[axis];
+	PhysicsSAPEndpoint tmp = endpoints[indexA];
+	endpoints[indexA] = endpoints[indexB];
+	endpoints[indexB] = tmp;
+	for (U32 i = 0; i < 2; ++i) {
+		U32 index = i == 0 ? indexA : indexB;
+		PhysicsSAPEndpoint *endpoint = endpoints + index;
+		PhysicsSAPProxy *proxy = sap->proxies + PhysicsSAPEndpointProxy(*endpoint);
+		if (PhysicsSAPEndpointIsMax(*endpoint)) {
+			proxy->maxIndex[axis] = index;
+		} else {
+			proxy->minIndex[axis] = index;
+		}
+	}
+}
+
+// NOTE(final): Insertion sort of a single endpoint towards the start.
+//				A min passing a max begins an overlap, a max passing a min ends an overlap.
+internal void PhysicsSAPSortDown(Physics *physics, PhysicsSAP *sap, U32 axis, U32 index) {
+	PhysicsSAPEndpoint *endpoints = sap->endpoints[axis];
+	while (index > 0 && PhysicsSAPEndpointLess(endpoints[index], endpoints[index - 1])) {
+		PhysicsSAPEndpoint *cur = endpoints + index;
+		PhysicsSAPEndpoint *prev = endpoints + index - 1;
+		if (PhysicsSAPEndpointIsMax(*cur) != PhysicsSAPEndpointIsMax(*prev)) {
+			PhysicsSAPEndpointsSwapped(physics, sap, PhysicsSAPEndpointProxy(*cur), PhysicsSAPEndpointProxy(*prev), !PhysicsSAPEndpointIsMax(*cur));
+		}
+		PhysicsSAPEndpointSwap(sap, axis, index - 1, index);
+		--index;
+	}
+}
+
+// NOTE(final): Insertion sort of a single endpoint towards the end.
+//				A max passing a min begins an overlap, a min passing a max ends an overlap.
+internal void PhysicsSAPSortUp(Physics *physics, PhysicsSAP *sap, U32 axis, U32 index) {
+	PhysicsSAPEndpoint *endpoints = sap->endpoints[axis];
+	while (index + 1 < sap->endpointCount && PhysicsSAPEndpointLess(endpoints[index + 1], endpoints[index])) {
+		PhysicsSAPEndpoint *cur = endpoints + index;
+		PhysicsSAPEndpoint *next = endpoints + index + 1;
+		if (PhysicsSAPEndpointIsMax(*cur) != PhysicsSAPEndpointIsMax(*next)) {
+			PhysicsSAPEndpointsSwapped(physics, sap, PhysicsSAPEndpointProxy(*cur), PhysicsSAPEndpointProxy(*next), PhysicsSAPEndpointIsMax(*cur));
+		}
+		PhysicsSAPEndpointSwap(sap, axis, index, index + 1);
+		++index;
+	}
+}
+
+external void PhysicsSAPMove(Physics *physics, PhysicsSAP *sap, U32 proxyId, const AABB &aabb) {
+	Assert(proxyId < sap->proxyCount);
+	PhysicsSAPProxy *proxy = sap->proxies + proxyId;
+	AABB oldAABB = proxy->aabb;
+	if (oldAABB.min.x == aabb.min.x && oldAABB.min.y == aabb.min.y && oldAABB.max.x == aabb.max.x && oldAABB.max.y == aabb.max.y) {
+		return;
+	}
+	proxy->aabb = aabb;
+	for (U32 axis = 0; axis < 2; ++axis) {
+		PhysicsSAPEndpoint *endpoints = sap->endpoints[axis];
+		endpoints[proxy->minIndex[axis]].value = aabb.min.p[axis];
+		endpoints[proxy->maxIndex[axis]].value = aabb.max.p[axis];
+
+		// NOTE(final): Grow first and shrink afterwards, so each endpoint moves in one direction only
+		if (aabb.min.p[axis] < oldAABB.min.p[axis]) {
+			PhysicsSAPSortDown(physics, sap, axis, proxy->minIndex[axis]);
+		}
+		if (aabb.max.p[axis] > oldAABB.max.p[axis]) {
+			PhysicsSAPSortUp(physics, sap, axis, proxy->maxIndex[axis]);
+		}
+		if (aabb.min.p[axis] > oldAABB.min.p[axis]) {
+			PhysicsSAPSortUp(physics, sap, axis, proxy->minIndex[axis]);
+		}
+		if (aabb.max.p[axis] < oldAABB.max.p[axis]) {
+			PhysicsSAPSortDown(physics, sap, axis, proxy->maxIndex[axis]);
+		}
+	}
+}
+
+internal U32 PhysicsSAPProxyAllocate(PhysicsSAP *sap, Body *body, const AABB &aabb) {
+	U32 result;
+	if (sap->freeProxy != PHYSICS_BROADPHASE_NULL_PROXY) {
+		result = sap->freeProxy;
+		sap->freeProxy = sap->proxies[result].nextFree;
+	} else {
+		Assert(sap->proxyCount < sap->proxyCapacity);
+		result = sap->proxyCount++;
+	}
+	PhysicsSAPProxy *proxy = sap->proxies + result;
+	*proxy = {};
+	proxy->body = body;
+	proxy->nextFree = PHYSICS_BROADPHASE_NULL_PROXY;
+	proxy->aabb = aabb;
+	return(result);
+}
+
+internal void PhysicsSAPProxyFree(PhysicsSAP *sap, U32 proxyId) {
+	PhysicsSAPProxy *proxy = sap->proxies + proxyId;
+	proxy->body = 0;
+	proxy->nextFree = sap->freeProxy;
+	sap->freeProxy = proxyId;
+}
+
+external U32 PhysicsSAPInsert(Physics *physics, PhysicsSAP *sap, Body *body, const AABB &aabb) {
+	// NOTE(final): Start at infinity, which is always the end of the endpoints and then move to the actual bounds
+	U32 result = PhysicsSAPProxyAllocate(sap, body, AABBFromMinMax(V2(FLOAT_MAX), V2(FLOAT_MAX)));
+	PhysicsSAPProxy *proxy = sap->proxies + result;
+	U32 minIndex = sap->endpointCount;
+	U32 maxIndex = sap->endpointCount + 1;
+	sap->endpointCount += 2;
+	for (U32 axis = 0; axis < 2; ++axis) {
+		PhysicsSAPEndpoint *endpoints = sap->endpoints[axis];
+		endpoints[minIndex].value = FLOAT_MAX;
+		endpoints[minIndex].data = result << 1;
+		endpoints[maxIndex].value = FLOAT_MAX;
+		endpoints[maxIndex].data = (result << 1) | 1;
+		proxy->minIndex[axis] = minIndex;
+		proxy->maxIndex[axis] = maxIndex;
+	}
+	PhysicsSAPMove(physics, sap, result, aabb);
+	return(result);
+}
+
+external void PhysicsSAPRemove(Physics *physics, PhysicsSAP *sap, U32 proxyId) {
+	// NOTE(final): Moving to infinity ends all overlaps and brings the endpoints to the end
+	PhysicsSAPMove(physics, sap, proxyId, AABBFromMinMax(V2(FLOAT_MAX), V2(FLOAT_MAX)));
+	for (U32 axis = 0; axis < 2; ++axis) {
+		Assert(sap->proxies[proxyId].minIndex[axis] == sap->endpointCount - 2);
+		Assert(sap->proxies[proxyId].maxIndex[axis] == sap->endpointCount - 1);
+	}
+	sap->endpointCount -= 2;
+	PhysicsSAPProxyFree(sap, proxyId);
+}
+
+// NOTE(final): Stable merge of two sorted endpoint ranges into the output
+internal void PhysicsSAPEndpointsMerge(const PhysicsSAPEndpoint *a, U32 countA, const PhysicsSAPEndpoint *b, U32 countB, PhysicsSAPEndpoint *output) {
+	U32 indexA = 0;
+	U32 indexB = 0;
+	while (indexA < countA && indexB < countB) {
+		if (PhysicsSAPEndpointLess(b[indexB], a[indexA])) {
+			*output++ = b[indexB++];
+		} else {
+			*output++ = a[indexA++];
+		}
+	}
+	while (indexA < countA) {
+		*output++ = a[indexA++];
+	}
+	while (indexB < countB) {
+		*output++ = b[indexB++];
+	}
+}
+
+// NOTE(final): Bottom-up merge sort, the temp endpoints must hold the same count
+internal void PhysicsSAPEndpointsSort(PhysicsSAPEndpoint *endpoints, PhysicsSAPEndpoint *temp, U32 count) {
+	PhysicsSAPEndpoint *source = endpoints;
+	PhysicsSAPEndpoint *target = temp;
+	for (U32 width = 1; width < count; width *= 2) {
+		for (U32 start = 0; start < count; start += width * 2) {
+			U32 middle = Min(start + width, count);
+			U32 end = Min(start + width * 2, count);
+			PhysicsSAPEndpointsMerge(source + start, middle - start, source + middle, end - middle, target + start);
+		}
+		PhysicsSAPEndpoint *swap = source;
+		source = target;
+		target = swap;
+	}
+	if (source != endpoints) {
+		for (U32 index = 0; index < count; ++index) {
+			endpoints[index] = source[index];
+		}
+	}
+}
+
+inline void PhysicsSAPEndpointsReindex(PhysicsSAP *sap, U32 axis) {
+	PhysicsSAPEndpoint *endpoints = sap->endpoints[axis];
+	for (U32 index = 0; index < sap->endpointCount; ++index) {
+		PhysicsSAPProxy *proxy = sap->proxies + PhysicsSAPEndpointProxy(endpoints[index]);
+		if (PhysicsSAPEndpointIsMax(endpoints[index])) {
+			proxy->maxIndex[axis] = index;
+		} else {
+			proxy->minIndex[axis] = index;
+		}
+	}
+}
+
+// NOTE(final): Inserting one by one would be quadratic, because every new endpoint is insertion sorted through all the others.
+//				Instead the new endpoints are sorted on its own and merged with the existing ones.
+//				A single sweep over the x axis finds all overlaps which contain a new proxy.
+external void PhysicsSAPInsertBatch(Physics *physics, PhysicsSAP *sap, Body **bodies, U32 bodyCount) {
+	if (bodyCount == 0) {
+		return;
+	}
+	TemporaryMemory tempMemory = TemporaryMemoryBegin(&physics->physicsMemory);
+	U32 oldEndpointCount = sap->endpointCount;
+	U32 newEndpointCount = bodyCount * 2;
+	Assert(oldEndpointCount + newEndpointCount <= sap->proxyCapacity * 2);
+	U8 *isNew = PushArray(&physics->physicsMemory, U8, sap->proxyCapacity);
+	U32 *activeProxies = PushArray(&physics->physicsMemory, U32, sap->proxyCapacity);
+	PhysicsSAPEndpoint *temp = PushArray(&physics->physicsMemory, PhysicsSAPEndpoint, oldEndpointCount + newEndpointCount, MemoryFlag::MemoryFlag_None);
+
+	for (U32 bodyIndex = 0; bodyIndex < bodyCount; ++bodyIndex) {
+		Body *body = bodies[bodyIndex];
+		U32 proxyId = PhysicsSAPProxyAllocate(sap, body, body->aabb);
+		body->proxyId = proxyId;
+		isNew[proxyId] = true;
+		for (U32 axis = 0; axis < 2; ++axis) {
+			PhysicsSAPEndpoint *endpoints = sap->endpoints[axis] + oldEndpointCount + bodyIndex * 2;
+			endpoints[0].value = body->aabb.min.p[axis];
+			endpoints[0].data = proxyId << 1;
+			endpoints[1].value = body->aabb.max.p[axis];
+			endpoints[1].data = (proxyId << 1) | 1;
+		}
+	}
+	sap->endpointCount = oldEndpointCount + newEndpointCount;
+
+	for (U32 axis = 0; axis < 2; ++axis) {
+		PhysicsSAPEndpoint *endpoints = sap->endpoints[axis];
+		PhysicsSAPEndpointsSort(endpoints + oldEndpointCount, temp, newEndpointCount);
+		PhysicsSAPEndpointsMerge(endpoints, oldEndpointCount, endpoints + oldEndpointCount, newEndpointCount, temp);
+		for (U32 index = 0; index < sap->endpointCount; ++index) {
+			endpoints[index] = temp[index];
+		}
+		PhysicsSAPEndpointsReindex(sap, axis);
+	}
+
+	U32 activeCount = 0;
+	PhysicsSAPEndpoint *endpoints = sap->endpoints[0];
+	for (U32 index = 0; index < sap->endpointCount; ++index) {
+		U32 proxyId = PhysicsSAPEndpointProxy(endpoints[index]);
+		if (PhysicsSAPEndpointIsMax(endpoints[index])) {
+			for (U32 activeIndex = 0; activeIndex < activeCount; ++activeIndex) {
+				if (activeProxies[activeIndex] == proxyId) {
+					activeProxies[activeIndex] = activeProxies[--activeCount];
+					break;
+				}
+			}
+		} else {
+			for (U32 activeIndex = 0; activeIndex < activeCount; ++activeIndex) {
+				U32 otherProxyId = activeProxies[activeIndex];
+				if (isNew[proxyId] || isNew[otherProxyId]) {
+					PhysicsSAPEndpointsSwapped(physics, sap, proxyId, otherProxyId, true);
+				}
+			}
+			activeProxies[activeCount++] = proxyId;
+		}
+	}
+	TemporaryMemoryEnd(&tempMemory);
+}
+
+// NOTE(final): Removes all pairs and endpoints of the removed proxies in one pass, instead of moving each proxy to infinity
+external void PhysicsSAPRemoveBatch(Physics *physics, PhysicsSAP *sap, Body **bodies, U32 bodyCount) {
+	if (bodyCount == 0) {
+		return;
+	}
+	TemporaryMemory tempMemory = TemporaryMemoryBegin(&physics->physicsMemory);
+	U8 *isRemoved = PushArray(&physics->physicsMemory, U8, sap->proxyCapacity);
+	for (U32 bodyIndex = 0; bodyIndex < bodyCount; ++bodyIndex) {
+		Assert(bodies[bodyIndex]->proxyId != PHYSICS_BROADPHASE_NULL_PROXY);
+		isRemoved[bodies[bodyIndex]->proxyId] = true;
+	}
+
+	// NOTE(final): Removing moves the last pair into the hole, which has already been visited when iterating backwards
+	PhysicsPairCache *cache = &sap->pairCache;
+	for (U32 pairIndex = cache->pairCount; pairIndex > 0; --pairIndex) {
+		PhysicsPair *pair = cache->pairs + pairIndex - 1;
+		if (isRemoved[pair->bodyA->proxyId] || isRemoved[pair->bodyB->proxyId]) {
+			PhysicsPairCacheRemove(cache, PhysicsPairKeyMake(pair->bodyA->bodyId, pair->bodyB->bodyId));
+		}
+	}
+
+	U32 endpointCount = 0;
+	for (U32 axis = 0; axis < 2; ++axis) {
+		PhysicsSAPEndpoint *endpoints = sap->endpoints[axis];
+		endpointCount = 0;
+		for (U32 index = 0; index < sap->endpointCount; ++index) {
+			if (!isRemoved[PhysicsSAPEndpointProxy(endpoints[index])]) {
+				endpoints[endpointCount++] = endpoints[index];
+			}
+		}
+	}
+	sap->endpointCount = endpointCount;
+	PhysicsSAPEndpointsReindex(sap, 0);
+	PhysicsSAPEndpointsReindex(sap, 1);
+
+	for (U32 bodyIndex = 0; bodyIndex < bodyCount; ++bodyIndex) {
+		PhysicsSAPProxyFree(sap, bodies[bodyIndex]->proxyId);
+	}
+	TemporaryMemoryEnd(&tempMemory);
+}
+
+external void PhysicsSAPFindPairs(Physics *physics, PhysicsSAP *sap) {
+	// NOTE(final): Static and sleeping bodies never move, so only awake bodies can swap endpoints
+	for (U32 bodyIndex = 0; bodyIndex < physics->bodyCount; ++bodyIndex) {
+		Body *body = physics->bodies[bodyIndex];
+		if (PhysicsBodyIsAwake(physics, body)) {
+			PhysicsSAPMove(physics, sap, body->proxyId, body->aabb);
+		}
+	}
+
+	// NOTE(final): The cache keeps the pairs of sleeping bodies, so they are available again when they wake up
+	PhysicsPairCache *cache = &sap->pairCache;
+	for (U32 pairIndex = 0; pairIndex < cache->pairCount; ++pairIndex) {
+		PhysicsPair *pair = cache->pairs + pairIndex;
+		if (PhysicsBodyIsAwake(physics, pair->bodyA) || PhysicsBodyIsAwake(physics, pair->bodyB)) {
+			PhysicsPairAdd(physics, pair->bodyA, pair->bodyB);
+		}
+	}
+}
+
+//
+// Broadphase
+//
+
+external void PhysicsBroadphaseInit(Physics *physics, const Vec2f &tileSize) {
+	switch (physics->broadphaseType) {
+		case PhysicsBroadphaseType::PhysicsBroadphaseType_Grid:
+		{
+			PhysicsGridInit(&physics->grid, &physics->physicsMemory, tileSize, PHYSICS_MAX_BODY_POOL_COUNT);
+		}; break;
+		case PhysicsBroadphaseType::PhysicsBroadphaseType_Tree:
+		{
+			PhysicsTreeInit(&physics->tree, &physics->physicsMemory, PHYSICS_MAX_BODY_POOL_COUNT);
+		}; break;
+		case PhysicsBroadphaseType::PhysicsBroadphaseType_SweepAndPrune:
+		{
+			PhysicsSAPInit(&physics->sap, &physics->physicsMemory, PHYSICS_MAX_BODY_POOL_COUNT, PHYSICS_MAX_PAIR_COUNT);
+		}; break;
+		InvalidDefaultCase;
+	}
+}
+
+external void PhysicsBroadphaseClear(Physics *physics) {
+	switch (physics->broadphaseType) {
+		case PhysicsBroadphaseType::PhysicsBroadphaseType_Grid:
+		{
+		}; break;
+		case PhysicsBroadphaseType::PhysicsBroadphaseType_Tree:
+		{
+			PhysicsTreeClear(&physics->tree);
+		}; break;
+		case PhysicsBroadphaseType::PhysicsBroadphaseType_SweepAndPrune:
+		{
+			PhysicsSAPClear(&physics->sap);
+		}; break;
+		InvalidDefaultCase;
+	}
+}
+
+external void PhysicsBroadphaseInsert(Physics *physics, Body *body) {
+	switch (physics->broadphaseType) {
+		case PhysicsBroadphaseType::PhysicsBroadphaseType_Grid:
+		{
+			// NOTE(final): Grid is rebuilt every step
+			body->proxyId = PHYSICS_BROADPHASE_NULL_PROXY;
+		}; break;
+		case PhysicsBroadphaseType::PhysicsBroadphaseType_Tree:
+		{
+			body->proxyId = PhysicsTreeInsert(&physics->tree, body, body->aabb);
+		}; break;
+		case PhysicsBroadphaseType::PhysicsBroadphaseType_SweepAndPrune:
+		{
+			body->proxyId = PhysicsSAPInsert(physics, &physics->sap, body, body->aabb);
+		}; break;
+		InvalidDefaultCase;
+	}
+}
+
+external void PhysicsBroadphaseInsertBatch(Physics *physics, Body **bodies, U32 bodyCount) {
+	switch (physics->broadphaseType) {
+		case PhysicsBroadphaseType::PhysicsBroadphaseType_Grid:
+		{
+			for (U32 bodyIndex = 0; bodyIndex < bodyCount; ++bodyIndex) {
+				bodies[bodyIndex]->proxyId = PHYSICS_BROADPHASE_NULL_PROXY;
+			}
+		}; break;
+		case PhysicsBroadphaseType::PhysicsBroadphaseType_Tree:
+		{
+			// NOTE(final): Tree inserts are logarithmic already
+			for (U32 bodyIndex = 0; bodyIndex < bodyCount; ++bodyIndex) {
+				Body *body = bodies[bodyIndex];
+				body->proxyId = PhysicsTreeInsert(&physics->tree, body, body->aabb);
+			}
+		}; break;
+		case PhysicsBroadphaseType::PhysicsBroadphaseType_SweepAndPrune:
+		{
+			PhysicsSAPInsertBatch(physics, &physics->sap, bodies, bodyCount);
+		}; break;
+		InvalidDefaultCase;
+	}
+}
+
+external void PhysicsBroadphaseRemove(Physics *physics, Body *body) {
+	if (body->proxyId == PHYSICS_BROADPHASE_NULL_PROXY) {
+		return;
+	}
+	switch (physics->broadphaseType) {
+		case PhysicsBroadphaseType::PhysicsBroadphaseType_Tree:
+		{
+			PhysicsTreeRemove(&physics->tree, body->proxyId);
+		}; break;
+		case PhysicsBroadphaseType::PhysicsBroadphaseType_SweepAndPrune:
+		{
+			PhysicsSAPRemove(physics, &physics->sap, body->proxyId);
+		}; break;
+		InvalidDefaultCase;
+	}
+	body->proxyId = PHYSICS_BROADPHASE_NULL_PROXY;
+}
+
+external void PhysicsBroadphaseFindPairs(Physics *physics) {
+	switch (physics->broadphaseType) {
+		case PhysicsBroadphaseType::PhysicsBroadphaseType_Grid:
+		{
+			PhysicsGridFindPairs(physics, &physics->grid);
+		}; break;
+		case PhysicsBroadphaseType::PhysicsBroadphaseType_Tree:
+		{
+			for (U32 bodyIndex = 0; bodyIndex < physics->bodyCount; ++bodyIndex) {
+				Body *body = physics->bodies[bodyIndex];
+				if (PhysicsBodyIsAwake(physics, body)) {
+					PhysicsTreeMove(&physics->tree, body->proxyId, body->aabb);
+				}
+			}
+			PhysicsTreeFindPairs(physics, &physics->tree);
+		}; break;
+		case PhysicsBroadphaseType::PhysicsBroadphaseType_SweepAndPrune:
+		{
+			PhysicsSAPFindPairs(physics, &physics->sap);
+		}; break;
+		InvalidDefaultCase;
+	}
+}
+
+
+external void PhysicsBroadphaseRemoveBatch(Physics *physics, Body **bodies, U32 bodyCount) {
+	switch (physics->broadphaseType) {
+		case PhysicsBroadphaseType::PhysicsBroadphaseType_Grid:
+		{
+		}; break;
+		case PhysicsBroadphaseType::PhysicsBroadphaseType_Tree:
+		{
+			for (U32 bodyIndex = 0; bodyIndex < bodyCount; ++bodyIndex) {
+				PhysicsTreeRemove(&physics->tree, bodies[bodyIndex]->proxyId);
+			}
+		}; break;
+		case PhysicsBroadphaseType::PhysicsBroadphaseType_SweepAndPrune:
+		{
+			PhysicsSAPRemoveBatch(physics, &physics->sap, bodies, bodyCount);
+		}; break;
+		InvalidDefaultCase;
+	}
+	for (U32 bodyIndex = 0; bodyIndex < bodyCount; ++bodyIndex) {
+		bodies[bodyIndex]->proxyId = PHYSICS_BROADPHASE_NULL_PROXY;
+	}
+}
\ No newline at end of file
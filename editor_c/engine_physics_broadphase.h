@@ -0,0 +1,182 @@
+#pragma once
+
+#include "engine_types.h"
+#include "engine_math.h"
+#include "engine_memory.h"
+
+struct Body;
+struct Physics;
+
+enum PhysicsBroadphaseType {
+	PhysicsBroadphaseType_Grid = 0,
+	PhysicsBroadphaseType_Tree,
+	PhysicsBroadphaseType_SweepAndPrune,
+
+	PhysicsBroadphaseType_Count,
+};
+
+struct PhysicsPair {
+	Body *bodyA;
+	Body *bodyB;
+};
+
+constant U32 PHYSICS_BROADPHASE_NULL_PROXY = 0xFFFFFFFF;
+
+inline U64 PhysicsPairKeyMake(U32 bodyIdA, U32 bodyIdB) {
+	U64 result = bodyIdA < bodyIdB ? (((U64)bodyIdA << 32) | bodyIdB) : (((U64)bodyIdB << 32) | bodyIdA);
+	return(result);
+}
+
+// NOTE(final): Tile boxes have no body, the highest bit keeps these keys apart from the body pair keys
+inline U64 PhysicsTileKeyMake(U32 tileBoxIndex, U32 bodyId) {
+	U64 result = ((U64)1 << 63) | ((U64)tileBoxIndex << 32) | bodyId;
+	return(result);
+}
+
+struct PhysicsStats {
+	// NOTE(final): Number of candidate pairs the broadphase has checked for AABB overlap
+	U32 pairsTested;
+	U32 pairCount;
+	// NOTE(final): Number of overlapping pairs dropped by the body filters or the pair filter
+	U32 pairsFiltered;
+	// NOTE(final): Number of merged tile boxes tested against dynamic bodies
+	U32 tileBoxesTested;
+	U32 contactCount;
+	// NOTE(final): Number of contacts dropped, because the contact or the step memory is used up
+	U32 contactOverflowCount;
+	U32 contactChunkCount;
+	// NOTE(final): Number of contacts which are warm started from the previous step
+	U32 warmStartCount;
+	U32 awakeBodyCount;
+	U32 islandCount;
+	U32 solverColorCount;
+	U32 solverBatchCount;
+	// NOTE(final): Iterations run by the solver, summed over all islands for the scalar solver
+	U32 solverVelocityIterationCount;
+	U32 solverPositionIterationCount;
+	U32 bulletCount;
+	// NOTE(final): Number of impacts the bullets have been stopped at
+	U32 bulletHitCount;
+	// NOTE(final): Number of candidate pairs with a sensor, which are tested for overlap only
+	U32 sensorPairCount;
+	U32 sensorOverlapCount;
+};
+
+// NOTE(final): Must be a power of two
+constant U32 PHYSICS_GRID_BUCKET_COUNT = 4096;
+
+struct PhysicsGridEntry {
+	Vec2i cell;
+	U32 bodyIndex;
+};
+
+struct PhysicsGrid {
+	// NOTE(final): Base cell size, the actual cell size is a multiple of it which fits the largest body
+	Vec2f tileSize;
+	Vec2f cellSize;
+
+	U32 *bucketStarts;
+	PhysicsGridEntry *entries;
+	Vec2i *bodyCells;
+	U32 *bodyBuckets;
+};
+
+external void PhysicsGridInit(PhysicsGrid *grid, MemoryBlock *memory, const Vec2f &tileSize, U32 maxBodyCount);
+external void PhysicsGridFindPairs(Physics *physics, PhysicsGrid *grid);
+
+constant U32 PHYSICS_TREE_NULL_NODE = 0xFFFFFFFF;
+// NOTE(final): Leafs are fattened by this margin, so small movements do not require a reinsert
+constant F32 PHYSICS_TREE_AABB_MARGIN = 0.1f;
+constant U32 PHYSICS_TREE_MAX_STACK_COUNT = 256;
+
+struct PhysicsTreeNode {
+	AABB aabb;
+	Body *body;
+	// NOTE(final): Parent is the next free node, when the node is in the free list
+	U32 parent;
+	U32 child1;
+	U32 child2;
+	// NOTE(final): Leaf = 0, Free = -1
+	S32 height;
+};
+
+struct PhysicsTree {
+	PhysicsTreeNode *nodes;
+	U32 nodeCapacity;
+	U32 nodeCount;
+	U32 root;
+	U32 freeList;
+};
+
+inline B32 PhysicsTreeNodeIsLeaf(const PhysicsTreeNode *node) {
+	B32 result = node->child1 == PHYSICS_TREE_NULL_NODE;
+	return(result);
+}
+
+external void PhysicsTreeInit(PhysicsTree *tree, MemoryBlock *memory, U32 maxBodyCount);
+external void PhysicsTreeClear(PhysicsTree *tree);
+external U32 PhysicsTreeInsert(PhysicsTree *tree, Body *body, const AABB &aabb);
+external void PhysicsTreeRemove(PhysicsTree *tree, U32 proxyId);
+external B32 PhysicsTreeMove(PhysicsTree *tree, U32 proxyId, const AABB &aabb);
+external void PhysicsTreeFindPairs(Physics *physics, PhysicsTree *tree);
+
+constant U32 PHYSICS_PAIR_CACHE_NULL = 0xFFFFFFFF;
+
+// NOTE(final): Hashed set of pairs keyed by both body ids, the pairs itself are stored dense
+struct PhysicsPairCache {
+	U32 *hashTable;
+	U32 hashMask;
+	U32 *nextPair;
+	U64 *keys;
+	PhysicsPair *pairs;
+	U32 pairCount;
+	U32 pairCapacity;
+};
+
+external void PhysicsPairCacheInit(PhysicsPairCache *cache, MemoryBlock *memory, U32 pairCapacity);
+external void PhysicsPairCacheClear(PhysicsPairCache *cache);
+external PhysicsPair *PhysicsPairCacheFind(PhysicsPairCache *cache, U64 key);
+external PhysicsPair *PhysicsPairCacheAdd(PhysicsPairCache *cache, U64 key, Body *bodyA, Body *bodyB);
+external B32 PhysicsPairCacheRemove(PhysicsPairCache *cache, U64 key);
+
+struct PhysicsSAPEndpoint {
+	F32 value;
+	// NOTE(final): Proxy index << 1 | isMax
+	U32 data;
+};
+
+struct PhysicsSAPProxy {
+	Body *body;
+	AABB aabb;
+	U32 minIndex[2];
+	U32 maxIndex[2];
+	U32 nextFree;
+};
+
+struct PhysicsSAP {
+	// NOTE(final): Sorted endpoints for the x and y axis, which are kept across frames
+	PhysicsSAPEndpoint *endpoints[2];
+	U32 endpointCount;
+	PhysicsSAPProxy *proxies;
+	U32 proxyCapacity;
+	U32 proxyCount;
+	U32 freeProxy;
+	PhysicsPairCache pairCache;
+};
+
+external void PhysicsSAPInit(PhysicsSAP *sap, MemoryBlock *memory, U32 maxBodyCount, U32 maxPairCount);
+external void PhysicsSAPClear(PhysicsSAP *sap);
+external U32 PhysicsSAPInsert(Physics *physics, PhysicsSAP *sap, Body *body, const AABB &aabb);
+external void PhysicsSAPRemove(Physics *physics, PhysicsSAP *sap, U32 proxyId);
+external void PhysicsSAPMove(Physics *physics, PhysicsSAP *sap, U32 proxyId, const AABB &aabb);
+external void PhysicsSAPFindPairs(Physics *physics, PhysicsSAP *sap);
+external void PhysicsSAPInsertBatch(Physics *physics, PhysicsSAP *sap, Body **bodies, U32 bodyCount);
+external void PhysicsSAPRemoveBatch(Physics *physics, PhysicsSAP *sap, Body **bodies, U32 bodyCount);
+
+external void PhysicsBroadphaseInit(Physics *physics, const Vec2f &tileSize);
+external void PhysicsBroadphaseClear(Physics *physics);
+external void PhysicsBroadphaseInsert(Physics *physics, Body *body);
+external void PhysicsBroadphaseRemove(Physics *physics, Body *body);
+external void PhysicsBroadphaseFindPairs(Physics *physics);
+external void PhysicsBroadphaseInsertBatch(Physics *physics, Body **bodies, U32 bodyCount);
+external void PhysicsBroadphaseRemoveBatch(Physics *physics, Body **bodies, U32 bodyCount);
@@ -1,20 +1,20 @@
 #include "engine_physics_collision.h"
 
-constant U32 PHYSICS_CONTACT_FEATURE_FACEA_PRIME = 3;
-constant U32 PHYSICS_CONTACT_FEATURE_FACEB_PRIME = 5;
-constant U32 PHYSICS_CONTACT_FEATURE_CLIP_PRIME = 11;
-constant U32 PHYSICS_CONTACT_FEATURE_SWAP_PRIME = 17;
+#include <emmintrin.h>
+#include <float.h>
 
-internal ManifoldInput MakeInputManifold(B32 flip, const Vec2f &localNormalA, const Transform &transformA, const Transform &transformB, U32 vertexCountA, Vec2f *localVertsA, U32 vertexCountB, Vec2f *localVertsB) {
+internal ManifoldInput MakeInputManifold(B32 flip, const Vec2f &localNormalA, const Transform &transformA, const Transform &transformB, EdgeShape *edgeA, EdgeShape *edgeB) {
 	ManifoldInput result = {};
 	result.flip = flip;
 	result.localNormalA = localNormalA;
 	result.transformA = transformA;
 	result.transformB = transformB;
-	result.localVertsA = localVertsA;
-	result.localVertsB = localVertsB;
-	result.vertexCountA = vertexCountA;
-	result.vertexCountB = vertexCountB;
+	result.edgeA = edgeA;
+	result.edgeB = edgeB;
+	result.localVertsA = edgeA->localVerts;
+	result.localVertsB = edgeB->localVerts;
+	result.vertexCountA = edgeA->vertexCount;
+	result.vertexCountB = edgeB->vertexCount;
 	Mat2f rotBTranspose = Mat2Transpose(transformB.rot);
 	result.rotBtoA = Mat2Mult(transformA.rot, rotBTranspose);
 	return (result);
@@ -164,6 +164,698 @@ external SATResult QuerySAT(const Transform &transformA, U32 vertexCountA, Vec2f
 	return(result);
 }
 
+// NOTE(final): Mask for the four vertices starting at the vertex index, which are below the vertex count and are not the excluded vertex
+inline __m128 GetVertexLaneMask(U32 vertexIndex, U32 vertexCount, U32 excludeIndex) {
+	__m128i laneIndices = _mm_add_epi32(_mm_set1_epi32((S32)vertexIndex), _mm_setr_epi32(0, 1, 2, 3));
+	__m128i inside = _mm_cmplt_epi32(laneIndices, _mm_set1_epi32((S32)vertexCount));
+	__m128i excluded = _mm_cmpeq_epi32(laneIndices, _mm_set1_epi32((S32)excludeIndex));
+	__m128 result = _mm_castsi128_ps(_mm_andnot_si128(excluded, inside));
+	return(result);
+}
+
+// NOTE(final): Index of the first vertex with the largest projection on the normal, four vertices at once.
+//				Returns the same vertex as the scalar search, because the first maximum wins in both.
+internal U32 GetSupportIndexSIMD(const Vec2f &normal, const EdgeShape *edge, U32 excludeIndex) {
+	const __m128 normalX = _mm_set1_ps(normal.x);
+	const __m128 normalY = _mm_set1_ps(normal.y);
+	const __m128 minProjection = _mm_set1_ps(-FLT_MAX);
+	__m128 projections[PHYSICS_MAX_EDGE_SHAPE_VERTEX_COUNT / 4];
+	__m128 maxProjection = minProjection;
+	U32 vertexCount = edge->vertexCount;
+	for (U32 vertexIndex = 0; vertexIndex < vertexCount; vertexIndex += 4) {
+		__m128 x = _mm_loadu_ps(edge->localVertsX + vertexIndex);
+		__m128 y = _mm_loadu_ps(edge->localVertsY + vertexIndex);
+		__m128 projection = _mm_add_ps(_mm_mul_ps(x, normalX), _mm_mul_ps(y, normalY));
+		__m128 mask = GetVertexLaneMask(vertexIndex, vertexCount, excludeIndex);
+		projection = _mm_or_ps(_mm_and_ps(mask, projection), _mm_andnot_ps(mask, minProjection));
+		projections[vertexIndex / 4] = projection;
+		maxProjection = _mm_max_ps(maxProjection, projection);
+	}
+	maxProjection = _mm_max_ps(maxProjection, _mm_shuffle_ps(maxProjection, maxProjection, _MM_SHUFFLE(2, 3, 0, 1)));
+	maxProjection = _mm_max_ps(maxProjection, _mm_shuffle_ps(maxProjection, maxProjection, _MM_SHUFFLE(1, 0, 3, 2)));
+	U32 result = 0;
+	for (U32 vertexIndex = 0; vertexIndex < vertexCount; vertexIndex += 4) {
+		S32 maxMask = _mm_movemask_ps(_mm_cmpeq_ps(projections[vertexIndex / 4], maxProjection));
+		if (maxMask) {
+			U32 lane = 0;
+			while (!(maxMask & (1 << lane))) {
+				++lane;
+			}
+			result = vertexIndex + lane;
+			break;
+		}
+	}
+	return(result);
+}
+
+external Vec2f GetSupportPointSIMD(const Vec2f &normal, const EdgeShape *edge) {
+	U32 supportIndex = GetSupportIndexSIMD(normal, edge, PHYSICS_EDGE_SHAPE_NULL_VERTEX);
+	Vec2f result = edge->localVerts[supportIndex];
+	return(result);
+}
+
+external Face GetFaceSIMD(const Vec2f &normal, const EdgeShape *edge) {
+	Assert(edge->vertexCount > 1);
+	U32 firstIndex = GetSupportIndexSIMD(normal, edge, PHYSICS_EDGE_SHAPE_NULL_VERTEX);
+	U32 secondIndex = GetSupportIndexSIMD(normal, edge, firstIndex);
+	Face result = {};
+	result.index = firstIndex;
+	result.points[0] = edge->localVerts[firstIndex];
+	result.points[1] = edge->localVerts[secondIndex];
+	return(result);
+}
+
+// NOTE(final): Same as QuerySAT, but the projections of four edges of A are computed at once and the support points of B are searched with SIMD.
+//				The cooked normals are normalized the same way and all operations are done in the same order as the scalar version, so the results are identical.
+external SATResult QuerySATSIMD(const Transform &transformA, const EdgeShape *edgeA, const Transform &transformB, const EdgeShape *edgeB) {
+	SATResult result = {};
+
+	Mat2f rotBTranspose = Mat2Transpose(transformB.rot);
+	Mat2f rotBtoA = Mat2Mult(transformA.rot, rotBTranspose);
+
+	U32 vertexCountA = edgeA->vertexCount;
+	const __m128 signMask = _mm_set1_ps(-0.0f);
+	F32 normalsForBX[4], normalsForBY[4];
+	F32 supportsX[4], supportsY[4], projections[4];
+	B32 first = true;
+	B32 separated = false;
+	for (U32 vertIndexA = 0; vertIndexA < vertexCountA && !separated; vertIndexA += 4) {
+		U32 laneCount = Min(4, vertexCountA - vertIndexA);
+
+		__m128 v0X = _mm_loadu_ps(edgeA->localVertsX + vertIndexA);
+		__m128 v0Y = _mm_loadu_ps(edgeA->localVertsY + vertIndexA);
+		__m128 localNormalX = _mm_loadu_ps(edgeA->localNormalsX + vertIndexA);
+		__m128 localNormalY = _mm_loadu_ps(edgeA->localNormalsY + vertIndexA);
+
+		// Bring normals A into its own space
+		__m128 normalForAX = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(transformA.rot.col1.x), localNormalX), _mm_mul_ps(_mm_set1_ps(transformA.rot.col2.x), localNormalY));
+		__m128 normalForAY = _mm_add_ps(_mm_mul_ps(_mm_set1_ps(transformA.rot.col1.y), localNormalX), _mm_mul_ps(_mm_set1_ps(transformA.rot.col2.y), localNormalY));
+		// Bring normals B into the space of A
+		__m128 normalForBX = _mm_xor_ps(_mm_add_ps(_mm_mul_ps(_mm_set1_ps(rotBtoA.col1.x), localNormalX), _mm_mul_ps(_mm_set1_ps(rotBtoA.col2.x), localNormalY)), signMask);
+		__m128 normalForBY = _mm_xor_ps(_mm_add_ps(_mm_mul_ps(_mm_set1_ps(rotBtoA.col1.y), localNormalX), _mm_mul_ps(_mm_set1_ps(rotBtoA.col2.y), localNormalY)), signMask);
+
+		// Get support points for B
+		_mm_storeu_ps(normalsForBX, normalForBX);
+		_mm_storeu_ps(normalsForBY, normalForBY);
+		for (U32 lane = 0; lane < 4; ++lane) {
+			Vec2f supportPointB = lane < laneCount ? GetSupportPointSIMD(V2(normalsForBX[lane], normalsForBY[lane]), edgeB) : V2();
+			supportsX[lane] = supportPointB.x;
+			supportsY[lane] = supportPointB.y;
+		}
+
+		// Get closest distances
+		__m128 pAX = _mm_add_ps(_mm_add_ps(_mm_mul_ps(_mm_set1_ps(transformA.rot.col1.x), v0X), _mm_mul_ps(_mm_set1_ps(transformA.rot.col2.x), v0Y)), _mm_set1_ps(transformA.pos.x));
+		__m128 pAY = _mm_add_ps(_mm_add_ps(_mm_mul_ps(_mm_set1_ps(transformA.rot.col1.y), v0X), _mm_mul_ps(_mm_set1_ps(transformA.rot.col2.y), v0Y)), _mm_set1_ps(transformA.pos.y));
+		__m128 supportX = _mm_loadu_ps(supportsX);
+		__m128 supportY = _mm_loadu_ps(supportsY);
+		__m128 pBX = _mm_add_ps(_mm_add_ps(_mm_mul_ps(_mm_set1_ps(transformB.rot.col1.x), supportX), _mm_mul_ps(_mm_set1_ps(transformB.rot.col2.x), supportY)), _mm_set1_ps(transformB.pos.x));
+		__m128 pBY = _mm_add_ps(_mm_add_ps(_mm_mul_ps(_mm_set1_ps(transformB.rot.col1.y), supportX), _mm_mul_ps(_mm_set1_ps(transformB.rot.col2.y), supportY)), _mm_set1_ps(transformB.pos.y));
+		__m128 projection = _mm_add_ps(_mm_mul_ps(_mm_sub_ps(pBX, pAX), normalForAX), _mm_mul_ps(_mm_sub_ps(pBY, pAY), normalForAY));
+		_mm_storeu_ps(projections, projection);
+
+		// Record axis of minimum penetration, the first separating axis stops the search
+		for (U32 lane = 0; lane < laneCount; ++lane) {
+			F32 proj = projections[lane];
+			if (proj > 0) {
+				result.success = false;
+				separated = true;
+				break;
+			}
+			if (first || proj > result.distance) {
+				first = false;
+				result.normal = edgeA->localNormals[vertIndexA + lane];
+				result.distance = proj;
+				result.success = true;
+			}
+		}
+	}
+
+	return(result);
+}
+
+// NOTE(final): Xorshift, returns a random number in the range of zero to one
+inline F32 CollisionTestRandom(U32 *state) {
+	U32 x = *state;
+	x ^= x << 13;
+	x ^= x >> 17;
+	x ^= x << 5;
+	*state = x;
+	F32 result = (F32)(x >> 8) / (F32)(1 << 24);
+	return(result);
+}
+
+// NOTE(final): Random cooked shape of the kind, the generic polygon kind gets a random vertex count up to the max vertex count.
+//				Polygon vertices are on an ellipse with random angle steps, so they are always convex and in counter clockwise order.
+internal Shape CollisionTestShapeMake(ShapeKind kind, U32 *state) {
+	Vec2f radius = V2(0.1f + CollisionTestRandom(state) * 2.0f, 0.1f + CollisionTestRandom(state) * 2.0f);
+	Shape result = {};
+	switch (kind) {
+		case ShapeKind::ShapeKind_Box:
+		{
+			result = MakeBoxShape(radius);
+		}; break;
+		case ShapeKind::ShapeKind_Circle:
+		{
+			result = MakeCircleShape(radius.x);
+		}; break;
+		case ShapeKind::ShapeKind_Polygon:
+		case ShapeKind::ShapeKind_Polygon3:
+		case ShapeKind::ShapeKind_Polygon4:
+		case ShapeKind::ShapeKind_Polygon5:
+		case ShapeKind::ShapeKind_Polygon6:
+		case ShapeKind::ShapeKind_Polygon7:
+		case ShapeKind::ShapeKind_Polygon8:
+		{
+			U32 vertexCount;
+			if (kind == ShapeKind::ShapeKind_Polygon) {
+				vertexCount = 3 + (U32)(CollisionTestRandom(state) * (PHYSICS_MAX_EDGE_SHAPE_VERTEX_COUNT - 2));
+			} else {
+				vertexCount = 3 + (kind - ShapeKind::ShapeKind_Polygon3);
+			}
+			F32 steps[PHYSICS_MAX_EDGE_SHAPE_VERTEX_COUNT];
+			F32 stepSum = 0;
+			for (U32 vertexIndex = 0; vertexIndex < vertexCount; ++vertexIndex) {
+				steps[vertexIndex] = 0.2f + CollisionTestRandom(state);
+				stepSum += steps[vertexIndex];
+			}
+			Vec2f verts[PHYSICS_MAX_EDGE_SHAPE_VERTEX_COUNT];
+			F32 angle = CollisionTestRandom(state) * 2.0f * PI32;
+			for (U32 vertexIndex = 0; vertexIndex < vertexCount; ++vertexIndex) {
+				verts[vertexIndex] = V2(Cos(angle) * radius.x, Sin(angle) * radius.y);
+				angle += steps[vertexIndex] / stepSum * 2.0f * PI32;
+			}
+			result = MakePolygonShape(vertexCount, verts);
+		}; break;
+		InvalidDefaultCase;
+	}
+	CookShape(&result, 1.0f);
+	return(result);
+}
+
+inline Transform CollisionTestTransformMake(U32 *state) {
+	Transform result = TransformMake(V2(CollisionTestRandom(state) * 4.0f - 2.0f, CollisionTestRandom(state) * 4.0f - 2.0f), CollisionTestRandom(state) * 2.0f * PI32);
+	return(result);
+}
+
+#ifdef _DEBUG
+// NOTE(final): Differential test of the SIMD kernels against the scalar versions, on random shape pairs with random transforms.
+//				Both versions do the same operations in the same order, so any difference is a mismatch. Returns the number of mismatches.
+external U32 CollisionSIMDSelfCheck(U32 seed, U32 pairCount) {
+	U32 state = seed ? seed : 1;
+	U32 result = 0;
+	for (U32 pairIndex = 0; pairIndex < pairCount; ++pairIndex) {
+		Shape shapeA = CollisionTestShapeMake(CollisionTestRandom(&state) < 0.25f ? ShapeKind::ShapeKind_Box : ShapeKind::ShapeKind_Polygon, &state);
+		Shape shapeB = CollisionTestShapeMake(CollisionTestRandom(&state) < 0.25f ? ShapeKind::ShapeKind_Box : ShapeKind::ShapeKind_Polygon, &state);
+		EdgeShape *edgeA = GetEdgeShape(&shapeA);
+		EdgeShape *edgeB = GetEdgeShape(&shapeB);
+		Transform transformA = CollisionTestTransformMake(&state);
+		Transform transformB = CollisionTestTransformMake(&state);
+
+		F32 normalAngle = CollisionTestRandom(&state) * 2.0f * PI32;
+		Vec2f normal = V2(Cos(normalAngle), Sin(normalAngle));
+		Vec2f support = GetSupportPointSIMD(normal, edgeA);
+		Vec2f supportCheck = GetSupportPoint(normal, edgeA->vertexCount, edgeA->localVerts);
+		if (support.x != supportCheck.x || support.y != supportCheck.y) {
+			++result;
+		}
+
+		Face face = GetFaceSIMD(normal, edgeA);
+		Face faceCheck = GetFace(normal, edgeA->vertexCount, edgeA->localVerts);
+		if (face.index != faceCheck.index || face.points[1].x != faceCheck.points[1].x || face.points[1].y != faceCheck.points[1].y) {
+			++result;
+		}
+
+		SATResult sat = QuerySATSIMD(transformA, edgeA, transformB, edgeB);
+		SATResult satCheck = QuerySAT(transformA, edgeA->vertexCount, edgeA->localVerts, transformB, edgeB->vertexCount, edgeB->localVerts);
+		if (sat.success != satCheck.success || sat.distance != satCheck.distance || sat.normal.x != satCheck.normal.x || sat.normal.y != satCheck.normal.y) {
+			++result;
+		}
+	}
+	return(result);
+}
+#endif
+
+// NOTE(final): Smallest and largest projection of all vertices on the axis, four vertices at once
+internal void GetProjectionRangeSIMD(const Vec2f &axis, const EdgeShape *edge, F32 *outMin, F32 *outMax) {
+	const __m128 axisX = _mm_set1_ps(axis.x);
+	const __m128 axisY = _mm_set1_ps(axis.y);
+	const __m128 maxValue = _mm_set1_ps(FLT_MAX);
+	const __m128 minValue = _mm_set1_ps(-FLT_MAX);
+	__m128 minProjection = maxValue;
+	__m128 maxProjection = minValue;
+	U32 vertexCount = edge->vertexCount;
+	for (U32 vertexIndex = 0; vertexIndex < vertexCount; vertexIndex += 4) {
+		__m128 x = _mm_loadu_ps(edge->localVertsX + vertexIndex);
+		__m128 y = _mm_loadu_ps(edge->localVertsY + vertexIndex);
+		__m128 projection = _mm_add_ps(_mm_mul_ps(x, axisX), _mm_mul_ps(y, axisY));
+		__m128 mask = GetVertexLaneMask(vertexIndex, vertexCount, PHYSICS_EDGE_SHAPE_NULL_VERTEX);
+		minProjection = _mm_min_ps(minProjection, _mm_or_ps(_mm_and_ps(mask, projection), _mm_andnot_ps(mask, maxValue)));
+		maxProjection = _mm_max_ps(maxProjection, _mm_or_ps(_mm_and_ps(mask, projection), _mm_andnot_ps(mask, minValue)));
+	}
+	minProjection = _mm_min_ps(minProjection, _mm_shuffle_ps(minProjection, minProjection, _MM_SHUFFLE(2, 3, 0, 1)));
+	minProjection = _mm_min_ps(minProjection, _mm_shuffle_ps(minProjection, minProjection, _MM_SHUFFLE(1, 0, 3, 2)));
+	maxProjection = _mm_max_ps(maxProjection, _mm_shuffle_ps(maxProjection, maxProjection, _MM_SHUFFLE(2, 3, 0, 1)));
+	maxProjection = _mm_max_ps(maxProjection, _mm_shuffle_ps(maxProjection, maxProjection, _MM_SHUFFLE(1, 0, 3, 2)));
+	*outMin = _mm_cvtss_f32(minProjection);
+	*outMax = _mm_cvtss_f32(maxProjection);
+}
+
+// NOTE(final): SAT for a box A against any edge shape B. Opposite faces of a box share an axis, so B is projected on the two box axis only.
+//				A box B is projected by its extends, so there is no vertex search at all.
+external SATResult QuerySATBox(const Transform &transformA, const BoxShape *boxA, const Transform &transformB, const EdgeShape *edgeB) {
+	SATResult result = {};
+
+	Mat2f rotBTranspose = Mat2Transpose(transformB.rot);
+	Vec2f distanceBetween = transformB.pos - transformA.pos;
+
+	// NOTE(final): Separation of B on the faces of A in edge order: Bottom, Right, Top, Left
+	F32 separations[4];
+	Vec2f axisA[2] = { transformA.rot.col1, transformA.rot.col2 };
+	F32 extendA[2] = { boxA->extend.x, boxA->extend.y };
+	for (U32 axisIndex = 0; axisIndex < 2; ++axisIndex) {
+		Vec2f axis = axisA[axisIndex];
+		Vec2f localAxisB = Vec2MultMat2(axis, rotBTranspose);
+		F32 minProjection, maxProjection;
+		if (edgeB->isBox) {
+			const BoxShape *boxB = (const BoxShape *)edgeB;
+			F32 radiusB = boxB->extend.x * Abs(localAxisB.x) + boxB->extend.y * Abs(localAxisB.y);
+			minProjection = -radiusB;
+			maxProjection = radiusB;
+		} else {
+			GetProjectionRangeSIMD(localAxisB, edgeB, &minProjection, &maxProjection);
+		}
+		F32 center = Vec2Dot(distanceBetween, axis);
+		F32 positiveSeparation = center + minProjection - extendA[axisIndex];
+		F32 negativeSeparation = -(center + maxProjection) - extendA[axisIndex];
+		if (axisIndex == 0) {
+			separations[3] = negativeSeparation;
+			separations[1] = positiveSeparation;
+		} else {
+			separations[0] = negativeSeparation;
+			separations[2] = positiveSeparation;
+		}
+	}
+
+	// NOTE(final): Same rules as the general SAT, the first face with the largest separation wins
+	for (U32 faceIndex = 0; faceIndex < 4; ++faceIndex) {
+		F32 separation = separations[faceIndex];
+		if (separation > 0) {
+			result.success = false;
+			break;
+		}
+		if (faceIndex == 0 || separation > result.distance) {
+			result.normal = boxA->localNormals[faceIndex];
+			result.distance = separation;
+			result.success = true;
+		}
+	}
+	return(result);
+}
+
+// NOTE(final): Box A moves by the motion against the resting box B, which is a ray against the slabs of both boxes added together.
+//				Boxes which overlap or touch at the start are no hit, the contacts push them apart.
+external TOIResult SweepAABB(const Vec2f &posA, const Vec2f &radiusA, const Vec2f &motion, const Vec2f &posB, const Vec2f &radiusB) {
+	TOIResult result = {};
+	Vec2f relPos = posB - posA;
+	Vec2f bothRadius = radiusA + radiusB;
+	F32 enterTime = -FLT_MAX;
+	F32 exitTime = FLT_MAX;
+	U32 enterAxis = 0;
+	for (U32 axis = 0; axis < 2; ++axis) {
+		F32 slabMin = relPos.p[axis] - bothRadius.p[axis];
+		F32 slabMax = relPos.p[axis] + bothRadius.p[axis];
+		F32 axisMotion = motion.p[axis];
+		if (axisMotion == 0) {
+			if (slabMin >= 0 || slabMax <= 0) {
+				return(result);
+			}
+			continue;
+		}
+		F32 axisEnter = slabMin / axisMotion;
+		F32 axisExit = slabMax / axisMotion;
+		if (axisEnter > axisExit) {
+			F32 temp = axisEnter;
+			axisEnter = axisExit;
+			axisExit = temp;
+		}
+		if (axisEnter > enterTime) {
+			enterTime = axisEnter;
+			enterAxis = axis;
+		}
+		exitTime = Min(exitTime, axisExit);
+	}
+	if (enterTime > 0 && enterTime <= 1.0f && enterTime < exitTime) {
+		result.hit = true;
+		result.time = enterTime;
+		result.normal.p[enterAxis] = motion.p[enterAxis] > 0 ? 1.0f : -1.0f;
+	}
+	return(result);
+}
+
+// NOTE(final): Farthest point of the shape in the direction, planes are half spaces and have no support point
+internal Vec2f GetShapeSupportPoint(Shape *shape, const Transform &transform, const Vec2f &direction) {
+	Vec2f result;
+	if (shape->type == ShapeType::ShapeType_Circle) {
+		result = transform.pos + direction * shape->circle.radius;
+	} else {
+		EdgeShape *edge = GetEdgeShape(shape);
+		Vec2f localDirection = Vec2MultMat2(direction, Mat2Transpose(transform.rot));
+		result = Vec2MultTransform(GetSupportPoint(localDirection, edge->vertexCount, edge->localVerts), transform);
+	}
+	return(result);
+}
+
+// NOTE(final): Gap between the projections of both shapes on the axis pointing from A to B
+internal F32 GetShapeAxisSeparation(Shape *shapeA, const Transform &transformA, Shape *shapeB, const Transform &transformB, const Vec2f &axis) {
+	F32 maxA = Vec2Dot(GetShapeSupportPoint(shapeA, transformA, axis), axis);
+	F32 minB;
+	if (shapeB->type == ShapeType::ShapeType_Plane) {
+		minB = Vec2Dot(transformB.pos, axis);
+	} else {
+		minB = Vec2Dot(GetShapeSupportPoint(shapeB, transformB, -axis), axis);
+	}
+	F32 result = minB - maxA;
+	return(result);
+}
+
+// NOTE(final): Axis from a circle center to the closest vertex of an edge shape, which separates a circle from a corner
+internal Vec2f GetCircleVertexAxis(const Vec2f &center, EdgeShape *edge, const Transform &transform) {
+	Vec2f closest = Vec2MultTransform(edge->localVerts[0], transform);
+	for (U32 vertexIndex = 1; vertexIndex < edge->vertexCount; ++vertexIndex) {
+		Vec2f v = Vec2MultTransform(edge->localVerts[vertexIndex], transform);
+		if (Vec2LengthSquared(v - center) < Vec2LengthSquared(closest - center)) {
+			closest = v;
+		}
+	}
+	Vec2f result = closest - center;
+	if (Vec2LengthSquared(result) > 0) {
+		result = Vec2Normalize(result);
+	}
+	return(result);
+}
+
+// NOTE(final): Lower bound of the distance between the shapes, the gap on any axis is never larger than the real distance.
+//				The face normals of both shapes, the axis between the centers and the axis to the closest vertex of a circle are tested.
+//				Only A moves, so a plane can be B only and is tested on its normal.
+external F32 GetShapeSeparation(Shape *shapeA, const Transform &transformA, Shape *shapeB, const Transform &transformB, Vec2f *outNormal) {
+	Assert(shapeA->type != ShapeType::ShapeType_Plane);
+	if (shapeB->type == ShapeType::ShapeType_Plane) {
+		*outNormal = -transformB.rot.col1;
+		F32 result = GetShapeAxisSeparation(shapeA, transformA, shapeB, transformB, *outNormal);
+		return(result);
+	}
+
+	F32 result = -FLT_MAX;
+	Vec2f axes[2 * PHYSICS_MAX_EDGE_SHAPE_VERTEX_COUNT + 2];
+	U32 axisCount = 0;
+	Vec2f centerAxis = transformB.pos - transformA.pos;
+	if (Vec2LengthSquared(centerAxis) > 0) {
+		axes[axisCount++] = Vec2Normalize(centerAxis);
+	}
+	B32 isCircleA = shapeA->type == ShapeType::ShapeType_Circle;
+	B32 isCircleB = shapeB->type == ShapeType::ShapeType_Circle;
+	if (!isCircleA) {
+		EdgeShape *edgeA = GetEdgeShape(shapeA);
+		for (U32 vertexIndex = 0; vertexIndex < edgeA->vertexCount; ++vertexIndex) {
+			axes[axisCount++] = Vec2MultMat2(edgeA->localNormals[vertexIndex], transformA.rot);
+		}
+		if (isCircleB) {
+			axes[axisCount++] = -GetCircleVertexAxis(transformB.pos, edgeA, transformA);
+		}
+	}
+	if (!isCircleB) {
+		EdgeShape *edgeB = GetEdgeShape(shapeB);
+		for (U32 vertexIndex = 0; vertexIndex < edgeB->vertexCount; ++vertexIndex) {
+			axes[axisCount++] = -Vec2MultMat2(edgeB->localNormals[vertexIndex], transformB.rot);
+		}
+		if (isCircleA) {
+			axes[axisCount++] = GetCircleVertexAxis(transformA.pos, edgeB, transformB);
+		}
+	}
+	Assert(axisCount <= ArrayCount(axes));
+	*outNormal = V2(0, 1);
+	for (U32 axisIndex = 0; axisIndex < axisCount; ++axisIndex) {
+		const Vec2f &axis = axes[axisIndex];
+		if (Vec2LengthSquared(axis) == 0) {
+			continue;
+		}
+		F32 separation = GetShapeAxisSeparation(shapeA, transformA, shapeB, transformB, axis);
+		if (separation > result) {
+			result = separation;
+			*outNormal = axis;
+		}
+	}
+	return(result);
+}
+
+// NOTE(final): Conservative advancement, A moves by the motion against the resting shape B until the gap is the target separation.
+//				The gap on the best axis shrinks linear with the motion, so advancing by the gap over the approaching speed never passes the impact.
+//				Shapes which are closer than the target at the start are no hit, the contacts keep them apart.
+external TOIResult QueryTOI(Shape *shapeA, const Transform &transformA, const Vec2f &motion, Shape *shapeB, const Transform &transformB, F32 targetSeparation) {
+	TOIResult result = {};
+	F32 tolerance = targetSeparation * 0.25f;
+	F32 time = 0;
+	for (U32 iteration = 0; iteration < PHYSICS_TOI_MAX_ITERATION_COUNT; ++iteration) {
+		Transform movedA = transformA;
+		movedA.pos += motion * time;
+		Vec2f normal;
+		F32 separation = GetShapeSeparation(shapeA, movedA, shapeB, transformB, &normal);
+		if (separation <= targetSeparation + tolerance) {
+			if (time > 0) {
+				result.hit = true;
+				result.time = time;
+				result.normal = normal;
+			}
+			break;
+		}
+		// NOTE(final): Moving away on a separating axis, so the shapes never touch
+		F32 approach = Vec2Dot(motion, normal);
+		if (approach <= 0) {
+			break;
+		}
+		time += (separation - targetSeparation) / approach;
+		if (time > 1.0f) {
+			break;
+		}
+		// NOTE(final): Out of iterations, stop where the shapes are still apart
+		if (iteration == PHYSICS_TOI_MAX_ITERATION_COUNT - 1) {
+			result.hit = true;
+			result.time = time;
+			result.normal = normal;
+		}
+	}
+	return(result);
+}
+
+// NOTE(final): First hit of the ray from the origin along the translation, the time is in the range of zero to the max fraction.
+//				The normal is the surface normal at the hit, which points against the ray. Rays starting inside a shape are no hit.
+external TOIResult RaycastShape(Shape *shape, const Transform &transform, const Vec2f &origin, const Vec2f &translation, F32 maxFraction) {
+	TOIResult result = {};
+	switch (shape->type) {
+		case ShapeType::ShapeType_Circle:
+		{
+			F32 radius = shape->circle.radius;
+			Vec2f relOrigin = origin - transform.pos;
+			F32 a = Vec2LengthSquared(translation);
+			F32 b = Vec2Dot(relOrigin, translation);
+			F32 c = Vec2LengthSquared(relOrigin) - radius * radius;
+			F32 discriminant = b * b - a * c;
+			if (c < 0 || a == 0 || discriminant < 0) {
+				break;
+			}
+			F32 time = -(b + SquareRoot(discriminant)) / a;
+			if (time >= 0 && time <= maxFraction) {
+				result.hit = true;
+				result.time = time;
+				result.normal = Vec2Normalize(relOrigin + translation * time);
+			}
+		}; break;
+		case ShapeType::ShapeType_Plane:
+		{
+			// NOTE(final): Planes are half spaces like in the contacts, so only rays from the front hit them
+			Vec2f normal = transform.rot.col1;
+			F32 distance = Vec2Dot(origin - transform.pos, normal);
+			F32 approach = -Vec2Dot(translation, normal);
+			if (distance < 0 || approach <= 0) {
+				break;
+			}
+			F32 time = distance / approach;
+			if (time <= maxFraction) {
+				result.hit = true;
+				result.time = time;
+				result.normal = normal;
+			}
+		}; break;
+		case ShapeType::ShapeType_LineSegment:
+		{
+			// NOTE(final): Both sides of a line segment are hit
+			EdgeShape *edge = GetEdgeShape(shape);
+			Vec2f v1 = Vec2MultTransform(edge->localVerts[0], transform);
+			Vec2f v2 = Vec2MultTransform(edge->localVerts[1], transform);
+			Vec2f lineAB = v2 - v1;
+			Vec2f normal = Vec2Normalize(Vec2Cross(lineAB, 1.0f));
+			F32 distance = Vec2Dot(origin - v1, normal);
+			F32 approach = -Vec2Dot(translation, normal);
+			if (approach == 0) {
+				break;
+			}
+			F32 time = distance / approach;
+			if (time < 0 || time > maxFraction) {
+				break;
+			}
+			F32 region = Vec2Dot(origin + translation * time - v1, lineAB) / Vec2LengthSquared(lineAB);
+			if (region >= 0 && region <= 1.0f) {
+				result.hit = true;
+				result.time = time;
+				result.normal = distance >= 0 ? normal : -normal;
+			}
+		}; break;
+		case ShapeType::ShapeType_Box:
+		case ShapeType::ShapeType_Polygon:
+		{
+			// NOTE(final): Clips the ray against the edge half spaces of the convex polygon in shape space
+			EdgeShape *edge = GetEdgeShape(shape);
+			Mat2f invRot = Mat2Transpose(transform.rot);
+			Vec2f localOrigin = Vec2MultMat2(origin - transform.pos, invRot);
+			Vec2f localTranslation = Vec2MultMat2(translation, invRot);
+			F32 lower = 0;
+			F32 upper = maxFraction;
+			U32 enterIndex = PHYSICS_EDGE_SHAPE_NULL_VERTEX;
+			B32 isMiss = false;
+			for (U32 vertexIndex = 0; vertexIndex < edge->vertexCount; ++vertexIndex) {
+				const Vec2f &normal = edge->localNormals[vertexIndex];
+				F32 numerator = Vec2Dot(normal, edge->localVerts[vertexIndex] - localOrigin);
+				F32 denominator = Vec2Dot(normal, localTranslation);
+				if (denominator == 0) {
+					if (numerator < 0) {
+						isMiss = true;
+						break;
+					}
+				} else if (denominator < 0 && numerator < lower * denominator) {
+					lower = numerator / denominator;
+					enterIndex = vertexIndex;
+				} else if (denominator > 0 && numerator < upper * denominator) {
+					upper = numerator / denominator;
+				}
+				if (upper < lower) {
+					isMiss = true;
+					break;
+				}
+			}
+			if (!isMiss && enterIndex != PHYSICS_EDGE_SHAPE_NULL_VERTEX) {
+				result.hit = true;
+				result.time = lower;
+				result.normal = Vec2MultMat2(edge->localNormals[enterIndex], transform.rot);
+			}
+		}; break;
+		InvalidDefaultCase;
+	}
+	return(result);
+}
+
+// NOTE(final): Compile-time vertex count, zero is the vertex count of the shape at runtime
+template <U32 VertexCount>
+inline U32 GetEdgeVertexCount(const EdgeShape *edge) {
+	U32 result = VertexCount ? VertexCount : edge->vertexCount;
+	Assert(result == edge->vertexCount);
+	return(result);
+}
+
+template <ShapeType Type>
+inline EdgeShape *GetEdgeShapeFixed(Shape *shape) {
+	EdgeShape *result;
+	if (Type == ShapeType::ShapeType_Box) {
+		result = &shape->box;
+	} else if (Type == ShapeType::ShapeType_Polygon) {
+		result = &shape->polygon;
+	} else if (Type == ShapeType::ShapeType_LineSegment) {
+		result = &shape->lineSegment;
+	} else {
+		result = GetEdgeShape(shape);
+	}
+	return(result);
+}
+
+// NOTE(final): Up to four vertices are unrolled by the compiler, more or unknown vertex counts use the SIMD search. Both return the first maximum.
+template <U32 VertexCount>
+inline U32 GetSupportIndexFixed(const Vec2f &normal, const EdgeShape *edge, U32 excludeIndex) {
+	if (VertexCount == 0 || VertexCount > 4) {
+		U32 result = GetSupportIndexSIMD(normal, edge, excludeIndex);
+		return(result);
+	}
+	U32 result = PHYSICS_EDGE_SHAPE_NULL_VERTEX;
+	F32 distance = 0;
+	for (U32 vertexIndex = 0; vertexIndex < VertexCount; ++vertexIndex) {
+		if (vertexIndex == excludeIndex) {
+			continue;
+		}
+		F32 p = Vec2Dot(edge->localVerts[vertexIndex], normal);
+		if (result == PHYSICS_EDGE_SHAPE_NULL_VERTEX || p > distance) {
+			distance = p;
+			result = vertexIndex;
+		}
+	}
+	return(result);
+}
+
+template <U32 VertexCount>
+inline Face GetFaceFixed(const Vec2f &normal, const EdgeShape *edge) {
+	U32 firstIndex = GetSupportIndexFixed<VertexCount>(normal, edge, PHYSICS_EDGE_SHAPE_NULL_VERTEX);
+	U32 secondIndex = GetSupportIndexFixed<VertexCount>(normal, edge, firstIndex);
+	Face result = {};
+	result.index = firstIndex;
+	result.points[0] = edge->localVerts[firstIndex];
+	result.points[1] = edge->localVerts[secondIndex];
+	return(result);
+}
+
+// NOTE(final): Same operations as QuerySAT with the cooked normals, so the results are identical. Unknown vertex counts use the SIMD version.
+template <U32 VertexCountA, U32 VertexCountB>
+inline SATResult QuerySATFixed(const Transform &transformA, const EdgeShape *edgeA, const Transform &transformB, const EdgeShape *edgeB) {
+	if (VertexCountA == 0 || VertexCountB == 0) {
+		SATResult result = QuerySATSIMD(transformA, edgeA, transformB, edgeB);
+		return(result);
+	}
+
+	SATResult result = {};
+
+	Mat2f rotBTranspose = Mat2Transpose(transformB.rot);
+	Mat2f rotBtoA = Mat2Mult(transformA.rot, rotBTranspose);
+
+	B32 first = true;
+	for (U32 vertIndexA = 0; vertIndexA < VertexCountA; vertIndexA++) {
+		Vec2f v0 = edgeA->localVerts[vertIndexA];
+		Vec2f localNormalA = edgeA->localNormals[vertIndexA];
+		Vec2f normalForA = Vec2MultMat2(localNormalA, transformA.rot);
+		Vec2f normalForB = -Vec2MultMat2(localNormalA, rotBtoA);
+
+		U32 supportIndexB = GetSupportIndexFixed<VertexCountB>(normalForB, edgeB, PHYSICS_EDGE_SHAPE_NULL_VERTEX);
+
+		Vec2f pA = Vec2MultTransform(v0, transformA);
+		Vec2f pB = Vec2MultTransform(edgeB->localVerts[supportIndexB], transformB);
+		Vec2f pAB = pB - pA;
+		F32 proj = Vec2Dot(pAB, normalForA);
+		if (proj > 0) {
+			result.success = false;
+			break;
+		}
+
+		if (first || proj > result.distance) {
+			first = false;
+			result.normal = localNormalA;
+			result.distance = proj;
+			result.success = true;
+		}
+	}
+
+#ifdef _DEBUG
+	SATResult check = QuerySAT(transformA, edgeA->vertexCount, (Vec2f *)edgeA->localVerts, transformB, edgeB->vertexCount, (Vec2f *)edgeB->localVerts);
+	Assert(check.success == result.success && check.distance == result.distance);
+	Assert(check.normal.x == result.normal.x && check.normal.y == result.normal.y);
+#endif
+	return(result);
+}
+
 external CONTACT_GENERATOR(CircleCircleContactGenerator) {
 	U32 result = 0;
 
@@ -200,10 +892,10 @@ external CONTACT_GENERATOR(CircleCircleContactGenerator) {
 	return(result);
 }
 
+// NOTE(final): Not specialized on the shape kind of A, because the loop is bound by the distance tests and a fixed vertex count did not make it faster
 external CONTACT_GENERATOR(EdgeCircleContactGenerator) {
 	U32 result = 0;
 
-	Vec2f posA = transformA.pos;
 	Vec2f posB = transformB.pos;
 	EdgeShape *edge = GetEdgeShape(shapeA);
 	CircleShape *circle = (CircleShape *)&shapeB->circle;
@@ -225,17 +917,16 @@ external CONTACT_GENERATOR(EdgeCircleContactGenerator) {
 	S32 bestEdgeIndex = 0;
 	for (U32 i = 0; i < vertexCountA; i++) {
 		Vec2f v0 = vertsA[i];
-		Vec2f v1 = vertsA[(i + 1) % vertexCountA];
-		Vec2f t = Vec2Normalize(v1 - v0);
-		Vec2f n = Vec2Cross(t, 1.0f);
+		Vec2f v1 = vertsA[i + 1 < vertexCountA ? i + 1 : 0];
+		Vec2f n = Vec2MultMat2(edge->localNormals[i], transformA.rot);
 
 		F32 region;
 		Vec2f closest = GetClosestPointOnLineSegment(posB, v0, v1, &region);
 		Vec2f distanceToEdge = posB - v0;
 		F32 distance = circle->radius - Vec2Dot(distanceToEdge, n);
 
-		// NOTE(final): Separation(Distance > 0) - early out
-		if (distance > 0) {
+		// NOTE(final): Distance is the penetration here, separation(Distance < 0) - early out
+		if (distance < 0) {
 			return 0;
 		}
 
@@ -294,19 +985,19 @@ external CONTACT_GENERATOR(PlaneCircleContactGenerator) {
 	return(result);
 }
 
-external CONTACT_GENERATOR(PlaneEdgeContactGenerator) {
+template <ShapeType TypeB, U32 VertexCountB>
+internal CONTACT_GENERATOR(PlaneEdgeContactGeneratorFixed) {
 	U32 result = 0;
 
 	Vec2f normal = transformA.rot.col1;
 	Vec2f posA = transformA.pos;
-	EdgeShape *edgeB = GetEdgeShape(shapeB);
-	Vec2f *localVertsB = edgeB->localVerts;
-	U32 vertexCountB = edgeB->vertexCount;
+	EdgeShape *edgeB = GetEdgeShapeFixed<TypeB>(shapeB);
+	GetEdgeVertexCount<VertexCountB>(edgeB);
 
 	Mat2f transposeB = Mat2Transpose(transformB.rot);
 	Vec2f normalB = -Vec2MultMat2(normal, transposeB);
 
-	Face faceB = GetFace(normalB, vertexCountB, localVertsB);
+	Face faceB = GetFaceFixed<VertexCountB>(normalB, edgeB);
 	Vec2f supportPointB = Vec2MultTransform(faceB.points[0], transformB);
 	Vec2f planePoint = posA;
 	Vec2f distanceToPlane = supportPointB - planePoint;
@@ -350,26 +1041,30 @@ external CONTACT_GENERATOR(PlaneEdgeContactGenerator) {
 	return(result);
 }
 
-external CONTACT_GENERATOR(EdgeEdgeContactGenerator) {
-	U32 result = 0;
+external CONTACT_GENERATOR(PlaneEdgeContactGenerator) {
+	U32 result = PlaneEdgeContactGeneratorFixed<ShapeType::ShapeType_None, 0>(world, transformA, transformB, shapeA, shapeB, offset, contacts);
+	return(result);
+}
 
-	Vec2f posA = transformA.pos;
-	EdgeShape *vbsA = GetEdgeShape(shapeA);
-	EdgeShape *vbsB = GetEdgeShape(shapeB);
+// NOTE(final): Specialized on the shape types and vertex counts of A and B, so the SAT and face loops are unrolled for boxes and small polygons
+template <ShapeType TypeA, U32 VertexCountA, ShapeType TypeB, U32 VertexCountB>
+internal CONTACT_GENERATOR(EdgeEdgeContactGeneratorFixed) {
+	U32 result = 0;
 
-	// NOTE(final): Get vertices for A and B
-	Vec2f *localVertsA = vbsA->localVerts;
-	Vec2f *localVertsB = vbsB->localVerts;
-	U32 vertexCountA = vbsA->vertexCount;
-	U32 vertexCountB = vbsB->vertexCount;
+	EdgeShape *vbsA = GetEdgeShapeFixed<TypeA>(shapeA);
+	EdgeShape *vbsB = GetEdgeShapeFixed<TypeB>(shapeB);
+	GetEdgeVertexCount<VertexCountA>(vbsA);
+	GetEdgeVertexCount<VertexCountB>(vbsB);
+	B32 isBoxA = TypeA == ShapeType::ShapeType_Box || (TypeA == ShapeType::ShapeType_None && vbsA->isBox);
+	B32 isBoxB = TypeB == ShapeType::ShapeType_Box || (TypeB == ShapeType::ShapeType_None && vbsB->isBox);
 
 	// NOTE(final): Query SAT for A -> B or B -> A
 	// NOTE(final): Separation (Distance > 0) - early out
-	SATResult resultA = QuerySAT(transformA, vertexCountA, localVertsA, transformB, vertexCountB, localVertsB);
+	SATResult resultA = isBoxA ? QuerySATBox(transformA, (BoxShape *)vbsA, transformB, vbsB) : QuerySATFixed<VertexCountA, VertexCountB>(transformA, vbsA, transformB, vbsB);
 	if (!resultA.success) {
 		return 0;
 	}
-	SATResult resultB = QuerySAT(transformB, vertexCountB, localVertsB, transformA, vertexCountA, localVertsA);
+	SATResult resultB = isBoxB ? QuerySATBox(transformB, (BoxShape *)vbsB, transformA, vbsA) : QuerySATFixed<VertexCountB, VertexCountA>(transformB, vbsB, transformA, vbsA);
 	if (!resultB.success) {
 		return 0;
 	}
@@ -379,16 +1074,17 @@ external CONTACT_GENERATOR(EdgeEdgeContactGenerator) {
 	const F32 kAbsTol = 0.001f;
 	ManifoldInput input;
 	if (resultA.distance > kRelTol * resultB.distance + kAbsTol) {
-		input = MakeInputManifold(false, resultA.normal, transformA, transformB, vertexCountA, localVertsA, vertexCountB, localVertsB);
+		input = MakeInputManifold(false, resultA.normal, transformA, transformB, vbsA, vbsB);
 	} else {
-		input = MakeInputManifold(true, resultB.normal, transformB, transformA, vertexCountB, localVertsB, vertexCountA, localVertsA);
+		input = MakeInputManifold(true, resultB.normal, transformB, transformA, vbsB, vbsA);
 	}
 
 	ManifoldOutput output = {};
 
 	// NOTE(final): Get face vertices for A and B
-	Face faceA = GetFace(input.localNormalA, input.vertexCountA, input.localVertsA);
-	Face faceB = GetFace(-Vec2MultMat2(input.localNormalA, input.rotBtoA), input.vertexCountB, input.localVertsB);
+	Vec2f localNormalB = -Vec2MultMat2(input.localNormalA, input.rotBtoA);
+	Face faceA = input.flip ? GetFaceFixed<VertexCountB>(input.localNormalA, input.edgeA) : GetFaceFixed<VertexCountA>(input.localNormalA, input.edgeA);
+	Face faceB = input.flip ? GetFaceFixed<VertexCountA>(localNormalB, input.edgeB) : GetFaceFixed<VertexCountB>(localNormalB, input.edgeB);
 
 	// NOTE(final): Transform face vertices for A and B
 	Vec2f sA1 = Vec2MultTransform(faceA.points[0], input.transformA);
@@ -435,5 +1131,181 @@ external CONTACT_GENERATOR(EdgeEdgeContactGenerator) {
 		SetContact(contact, output.distances[i], output.normal, output.points[i], feature);
 	}
 
+	return(result);
+}
+
+external CONTACT_GENERATOR(EdgeEdgeContactGenerator) {
+	U32 result = EdgeEdgeContactGeneratorFixed<ShapeType::ShapeType_None, 0, ShapeType::ShapeType_None, 0>(world, transformA, transformB, shapeA, shapeB, offset, contacts);
+	return(result);
+}
+
+enum ContactShapeCategory {
+	ContactShapeCategory_None = 0,
+	ContactShapeCategory_Plane,
+	ContactShapeCategory_Edge,
+	ContactShapeCategory_Circle,
+};
+
+template <U32 Kind>
+struct ContactShapeKindTraits {
+	static constexpr U32 category = Kind == ShapeKind::ShapeKind_Plane ? ContactShapeCategory_Plane : (Kind == ShapeKind::ShapeKind_Circle ? ContactShapeCategory_Circle : (Kind == ShapeKind::ShapeKind_None ? ContactShapeCategory_None : ContactShapeCategory_Edge));
+	static constexpr ShapeType type = Kind == ShapeKind::ShapeKind_LineSegment ? ShapeType::ShapeType_LineSegment : (Kind == ShapeKind::ShapeKind_Box ? ShapeType::ShapeType_Box : ShapeType::ShapeType_Polygon);
+	static constexpr U32 vertexCount = Kind == ShapeKind::ShapeKind_LineSegment ? 2 : (Kind == ShapeKind::ShapeKind_Box ? 4 : (Kind >= ShapeKind::ShapeKind_Polygon3 && Kind < ShapeKind::ShapeKind_Circle ? Kind - ShapeKind::ShapeKind_Polygon3 + 3 : 0));
+};
+
+// NOTE(final): Chooses the generator by the shape categories, pairs without a generator stay null
+template <U32 CategoryA, U32 CategoryB, U32 KindA, U32 KindB>
+struct ContactGeneratorSelect {
+	static constexpr generate_contacts *proc = 0;
+};
+template <U32 KindA, U32 KindB>
+struct ContactGeneratorSelect<ContactShapeCategory_Circle, ContactShapeCategory_Circle, KindA, KindB> {
+	static constexpr generate_contacts *proc = CircleCircleContactGenerator;
+};
+template <U32 KindA, U32 KindB>
+struct ContactGeneratorSelect<ContactShapeCategory_Plane, ContactShapeCategory_Circle, KindA, KindB> {
+	static constexpr generate_contacts *proc = PlaneCircleContactGenerator;
+};
+template <U32 KindA, U32 KindB>
+struct ContactGeneratorSelect<ContactShapeCategory_Edge, ContactShapeCategory_Circle, KindA, KindB> {
+	static constexpr generate_contacts *proc = EdgeCircleContactGenerator;
+};
+template <U32 KindA, U32 KindB>
+struct ContactGeneratorSelect<ContactShapeCategory_Plane, ContactShapeCategory_Edge, KindA, KindB> {
+	static constexpr generate_contacts *proc = PlaneEdgeContactGeneratorFixed<ContactShapeKindTraits<KindB>::type, ContactShapeKindTraits<KindB>::vertexCount>;
+};
+template <U32 KindA, U32 KindB>
+struct ContactGeneratorSelect<ContactShapeCategory_Edge, ContactShapeCategory_Edge, KindA, KindB> {
+	static constexpr generate_contacts *proc = EdgeEdgeContactGeneratorFixed<ContactShapeKindTraits<KindA>::type, ContactShapeKindTraits<KindA>::vertexCount, ContactShapeKindTraits<KindB>::type, ContactShapeKindTraits<KindB>::vertexCount>;
+};
+
+// NOTE(final): Shape pairs are ordered by kind, so A is always the plane or the edge shape and only type A <= type B is set
+#define CONTACT_GENERATOR_ENTRY(kindA, kindB) ContactGeneratorSelect<(kindA <= kindB ? ContactShapeKindTraits<kindA>::category : ContactShapeCategory_None), ContactShapeKindTraits<kindB>::category, kindA, kindB>::proc
+#define CONTACT_GENERATOR_ROW(kindA) { \
+	CONTACT_GENERATOR_ENTRY(kindA, 0), CONTACT_GENERATOR_ENTRY(kindA, 1), CONTACT_GENERATOR_ENTRY(kindA, 2), CONTACT_GENERATOR_ENTRY(kindA, 3), \
+	CONTACT_GENERATOR_ENTRY(kindA, 4), CONTACT_GENERATOR_ENTRY(kindA, 5), CONTACT_GENERATOR_ENTRY(kindA, 6), CONTACT_GENERATOR_ENTRY(kindA, 7), \
+	CONTACT_GENERATOR_ENTRY(kindA, 8), CONTACT_GENERATOR_ENTRY(kindA, 9), CONTACT_GENERATOR_ENTRY(kindA, 10), CONTACT_GENERATOR_ENTRY(kindA, 11), \
+}
+
+// NOTE(final): The rows list the columns of every shape kind explicitly
+StaticAssert(ShapeKind::ShapeKind_Count == 12);
+
+// NOTE(final): One row for every shape kind
+global_variable constexpr generate_contacts *globalContactGenerators[][ShapeKind::ShapeKind_Count] = {
+	CONTACT_GENERATOR_ROW(0),
+	CONTACT_GENERATOR_ROW(1),
+	CONTACT_GENERATOR_ROW(2),
+	CONTACT_GENERATOR_ROW(3),
+	CONTACT_GENERATOR_ROW(4),
+	CONTACT_GENERATOR_ROW(5),
+	CONTACT_GENERATOR_ROW(6),
+	CONTACT_GENERATOR_ROW(7),
+	CONTACT_GENERATOR_ROW(8),
+	CONTACT_GENERATOR_ROW(9),
+	CONTACT_GENERATOR_ROW(10),
+	CONTACT_GENERATOR_ROW(11),
+};
+StaticAssert(ArrayCount(globalContactGenerators) == ShapeKind::ShapeKind_Count);
+
+external generate_contacts *GetContactGenerator(ShapeKind kindA, ShapeKind kindB) {
+	Assert(kindA <= kindB);
+	generate_contacts *result = globalContactGenerators[kindA][kindB];
+	return(result);
+}
+
+inline ContactShapeCategory GetContactShapeCategory(ShapeKind kind) {
+	ContactShapeCategory result = ContactShapeCategory_Edge;
+	if (kind == ShapeKind::ShapeKind_Plane) {
+		result = ContactShapeCategory_Plane;
+	} else if (kind == ShapeKind::ShapeKind_Circle) {
+		result = ContactShapeCategory_Circle;
+	}
+	return(result);
+}
+
+// NOTE(final): Generator which reads the vertex counts at runtime, which was used for every pair before the kind table
+internal generate_contacts *GetRuntimeContactGenerator(ShapeKind kindA, ShapeKind kindB) {
+	ContactShapeCategory categoryA = GetContactShapeCategory(kindA);
+	ContactShapeCategory categoryB = GetContactShapeCategory(kindB);
+	generate_contacts *result = 0;
+	if (categoryA == ContactShapeCategory_Circle && categoryB == ContactShapeCategory_Circle) {
+		result = CircleCircleContactGenerator;
+	} else if (categoryA == ContactShapeCategory_Plane && categoryB == ContactShapeCategory_Circle) {
+		result = PlaneCircleContactGenerator;
+	} else if (categoryA == ContactShapeCategory_Plane && categoryB == ContactShapeCategory_Edge) {
+		result = PlaneEdgeContactGenerator;
+	} else if (categoryA == ContactShapeCategory_Edge && categoryB == ContactShapeCategory_Circle) {
+		result = EdgeCircleContactGenerator;
+	} else if (categoryA == ContactShapeCategory_Edge && categoryB == ContactShapeCategory_Edge) {
+		result = EdgeEdgeContactGenerator;
+	}
+	return(result);
+}
+
+internal U64 ContactGeneratorBenchmarkRun(generate_contacts *generator, const Shape *shapes, const Transform *transforms, U32 pairCount, Contact *contacts, U32 *contactCounts) {
+	U64 startCycles = __rdtsc();
+	for (U32 pairIndex = 0; pairIndex < pairCount; ++pairIndex) {
+		Shape *shapeA = (Shape *)shapes + pairIndex * 2;
+		Shape *shapeB = shapeA + 1;
+		contactCounts[pairIndex] = generator(0, transforms[pairIndex * 2], transforms[pairIndex * 2 + 1], shapeA, shapeB, pairIndex * PHYSICS_MAX_GENERATOR_CONTACT_COUNT, contacts);
+	}
+	U64 result = __rdtsc() - startCycles;
+	return(result);
+}
+
+// NOTE(final): Times the generator of the kind table against the runtime generator on the same random pairs and compares their contacts.
+//				Boxes, polygons and circles are supported. The pairs and contacts are pushed on the memory, which is released afterwards.
+external ContactGeneratorBenchmarkResult ContactGeneratorBenchmark(MemoryBlock *memory, ShapeKind kindA, ShapeKind kindB, U32 pairCount, U32 repeatCount, U32 seed) {
+	Assert(kindA <= kindB);
+	Assert(repeatCount > 0);
+	ContactGeneratorBenchmarkResult result = {};
+	generate_contacts *runtimeGenerator = GetRuntimeContactGenerator(kindA, kindB);
+	generate_contacts *specializedGenerator = GetContactGenerator(kindA, kindB);
+	Assert(runtimeGenerator && specializedGenerator);
+
+	TemporaryMemory tempMemory = TemporaryMemoryBegin(memory);
+	Shape *shapes = PushArray(memory, Shape, pairCount * 2, MemoryFlag::MemoryFlag_None);
+	Transform *transforms = PushArray(memory, Transform, pairCount * 2, MemoryFlag::MemoryFlag_None);
+	Contact *runtimeContacts = PushArray(memory, Contact, pairCount * PHYSICS_MAX_GENERATOR_CONTACT_COUNT, MemoryFlag::MemoryFlag_None);
+	Contact *specializedContacts = PushArray(memory, Contact, pairCount * PHYSICS_MAX_GENERATOR_CONTACT_COUNT, MemoryFlag::MemoryFlag_None);
+	U32 *runtimeCounts = PushArray(memory, U32, pairCount, MemoryFlag::MemoryFlag_None);
+	U32 *specializedCounts = PushArray(memory, U32, pairCount, MemoryFlag::MemoryFlag_None);
+	U32 state = seed ? seed : 1;
+	for (U32 pairIndex = 0; pairIndex < pairCount; ++pairIndex) {
+		shapes[pairIndex * 2] = CollisionTestShapeMake(kindA, &state);
+		shapes[pairIndex * 2 + 1] = CollisionTestShapeMake(kindB, &state);
+		transforms[pairIndex * 2] = CollisionTestTransformMake(&state);
+		transforms[pairIndex * 2 + 1] = CollisionTestTransformMake(&state);
+	}
+
+	// NOTE(final): Best of all repeats, the generators take turns so both see the same cache and clock state
+	for (U32 repeatIndex = 0; repeatIndex < repeatCount; ++repeatIndex) {
+		U64 runtimeCycles = ContactGeneratorBenchmarkRun(runtimeGenerator, shapes, transforms, pairCount, runtimeContacts, runtimeCounts);
+		U64 specializedCycles = ContactGeneratorBenchmarkRun(specializedGenerator, shapes, transforms, pairCount, specializedContacts, specializedCounts);
+		if (repeatIndex == 0 || runtimeCycles < result.runtimeCycles) {
+			result.runtimeCycles = runtimeCycles;
+		}
+		if (repeatIndex == 0 || specializedCycles < result.specializedCycles) {
+			result.specializedCycles = specializedCycles;
+		}
+	}
+
+	for (U32 pairIndex = 0; pairIndex < pairCount; ++pairIndex) {
+		result.contactCount += specializedCounts[pairIndex];
+		if (runtimeCounts[pairIndex] != specializedCounts[pairIndex]) {
+			++result.mismatchCount;
+			continue;
+		}
+		for (U32 contactIndex = 0; contactIndex < specializedCounts[pairIndex]; ++contactIndex) {
+			const Contact *runtimeContact = runtimeContacts + pairIndex * PHYSICS_MAX_GENERATOR_CONTACT_COUNT + contactIndex;
+			const Contact *specializedContact = specializedContacts + pairIndex * PHYSICS_MAX_GENERATOR_CONTACT_COUNT + contactIndex;
+			if (runtimeContact->distance != specializedContact->distance || runtimeContact->feature != specializedContact->feature ||
+				runtimeContact->normal.x != specializedContact->normal.x || runtimeContact->normal.y != specializedContact->normal.y ||
+				runtimeContact->point.x != specializedContact->point.x || runtimeContact->point.y != specializedContact->point.y) {
+				++result.mismatchCount;
+			}
+		}
+	}
+	TemporaryMemoryEnd(&tempMemory);
 	return(result);
 }
\ No newline at end of file
@@ -2,6 +2,7 @@
 
 #include "engine_types.h"
 #include "engine_math.h"
+#include "engine_memory.h"
 
 #include "engine_physics_shapes.h"
 #include "engine_physics_contact.h"
@@ -24,6 +25,8 @@ struct ManifoldInput {
 	U32 vertexCountB;
 	Vec2f *localVertsA;
 	Vec2f *localVertsB;
+	EdgeShape *edgeA;
+	EdgeShape *edgeB;
 };
 
 struct ManifoldOutput {
@@ -53,6 +56,19 @@ struct ContactGenerator {
 	generate_contacts *proc;
 };
 
+// NOTE(final): Maximum number of contacts a generator creates for a single pair
+constant U32 PHYSICS_MAX_GENERATOR_CONTACT_COUNT = 2;
+
+// NOTE(final): Time of impact in the range of zero to one of the motion, the normal points from the moving shape to the other shape
+struct TOIResult {
+	B32 hit;
+	F32 time;
+	Vec2f normal;
+};
+
+constant U32 PHYSICS_TOI_MAX_ITERATION_COUNT = 20;
+
+
 inline B32 IsPointInAABB(const AABB &aabb, const Vec2f &point) {
 	B32 result = (point.x >= aabb.min.x && point.x <= aabb.max.x) && (point.y >= aabb.min.y && point.y <= aabb.max.y);
 	return(result);
@@ -88,6 +104,30 @@ external ClipResult ClipToSegment(const Vec2f &normal, const Vec2f &ref1, const
 external ClipResult ClipToPlane(const Vec2f &normal, const Vec2f &planePoint, const Vec2f &inc1, const Vec2f &inc2);
 external Face GetFace(const Vec2f &normal, U32 vertexCount, Vec2f *verts);
 external SATResult QuerySAT(const Transform &transformA, U32 vertexCountA, Vec2f *localVertsA, const Transform &transformB, U32 vertexCountB, Vec2f *localVertsB);
+external Vec2f GetSupportPointSIMD(const Vec2f &normal, const EdgeShape *edge);
+external Face GetFaceSIMD(const Vec2f &normal, const EdgeShape *edge);
+external SATResult QuerySATSIMD(const Transform &transformA, const EdgeShape *edgeA, const Transform &transformB, const EdgeShape *edgeB);
+#ifdef _DEBUG
+// NOTE(final): Compares the SIMD kernels with the scalar versions on random shape pairs, returns the number of mismatches
+external U32 CollisionSIMDSelfCheck(U32 seed, U32 pairCount);
+#endif
+external SATResult QuerySATBox(const Transform &transformA, const BoxShape *boxA, const Transform &transformB, const EdgeShape *edgeB);
+external TOIResult SweepAABB(const Vec2f &posA, const Vec2f &radiusA, const Vec2f &motion, const Vec2f &posB, const Vec2f &radiusB);
+external F32 GetShapeSeparation(Shape *shapeA, const Transform &transformA, Shape *shapeB, const Transform &transformB, Vec2f *outNormal);
+external TOIResult QueryTOI(Shape *shapeA, const Transform &transformA, const Vec2f &motion, Shape *shapeB, const Transform &transformB, F32 targetSeparation);
+external TOIResult RaycastShape(Shape *shape, const Transform &transform, const Vec2f &origin, const Vec2f &translation, F32 maxFraction);
+// NOTE(final): Generator specialized on both shape kinds, only ordered pairs with kind A <= kind B have a generator
+external generate_contacts *GetContactGenerator(ShapeKind kindA, ShapeKind kindB);
+
+// NOTE(final): Best times of all repeats in CPU cycles for the runtime generator and the generator of the kind table
+struct ContactGeneratorBenchmarkResult {
+	U64 runtimeCycles;
+	U64 specializedCycles;
+	U32 contactCount;
+	// NOTE(final): Number of pairs or contacts which differ between both generators, must be zero
+	U32 mismatchCount;
+};
+external ContactGeneratorBenchmarkResult ContactGeneratorBenchmark(MemoryBlock *memory, ShapeKind kindA, ShapeKind kindB, U32 pairCount, U32 repeatCount, U32 seed);
 
 external CONTACT_GENERATOR(CircleCircleContactGenerator);
 external CONTACT_GENERATOR(EdgeCircleContactGenerator);
@@ -3,14 +3,28 @@
 #include "engine_types.h"
 #include "engine_math.h"
 
+struct Body;
+
+// NOTE(final): Contact features are a sum of the face/clip indices multiplied by these primes
+constant U32 PHYSICS_CONTACT_FEATURE_FACEA_PRIME = 3;
+constant U32 PHYSICS_CONTACT_FEATURE_FACEB_PRIME = 5;
+constant U32 PHYSICS_CONTACT_FEATURE_CLIP_PRIME = 11;
+constant U32 PHYSICS_CONTACT_FEATURE_SWAP_PRIME = 17;
+
 struct Contact {
+	Body *bodyA;
+	Body *bodyB;
+	// NOTE(final): Identifies the pair of colliders, together with the feature this identifies a contact across frames
+	U64 key;
 	Vec2f normal;
 	F32 distance;
 	Vec2f point;
+	// NOTE(final): Accumulated split impulse of the position solver, this is never warm started
 	F32 bias;
 	F32 normalImpulse;
 	F32 tangentImpulse;
 	Vec2f rA, rB;
 	F32 massNormal, massTangent;
+	F32 invMassA, invMassB;
 	U32 feature;
-};
+};
\ No newline at end of file
@@ -0,0 +1,371 @@
+#include "engine_physics_query.h"
+
+#include <xmmintrin.h>
+#include <float.h>
+
+#define PHYSICS_QUERY_VISITOR(name) void name(const Physics *physics, Body *body, void *data)
+typedef PHYSICS_QUERY_VISITOR(physics_query_visitor);
+
+inline AABB PhysicsQueryBodyBounds(const Physics *physics, const Body *body) {
+	AABB result = AABBFromCenterExt(physics->bodyData.positions[body->index], physics->bodyData.radii[body->index]);
+	return(result);
+}
+
+inline B32 PhysicsQueryShouldHit(const Physics *physics, const PhysicsFilter &filter, B32 includeSensors, const Body *body) {
+	B32 result = (includeSensors || !PhysicsBodyIsSensor(physics, body)) && PhysicsFilterShouldCollide(filter, body->filter);
+	return(result);
+}
+
+inline Transform PhysicsQueryBodyTransform(const Physics *physics, const Body *body) {
+	Transform result = TransformMult(body->shape.localTransform, TransformMakeTranslation(physics->bodyData.positions[body->index]));
+	return(result);
+}
+
+// NOTE(final): Calls the visitor for every body whose broadphase bounds overlap the bounds.
+//				The tree bounds are fattened, so the visitor must test the bounds of the body itself.
+//				Without the tree the bounds of the body are computed from its position, the body bounds are from before the solver changed the velocity.
+internal void PhysicsQueryOverlaps(const Physics *physics, const AABB &aabb, physics_query_visitor *visitor, void *data) {
+	const PhysicsTree *tree = &physics->tree;
+	if (physics->broadphaseType == PhysicsBroadphaseType::PhysicsBroadphaseType_Tree) {
+		if (tree->root == PHYSICS_TREE_NULL_NODE) {
+			return;
+		}
+		U32 stack[PHYSICS_TREE_MAX_STACK_COUNT];
+		U32 stackCount = 0;
+		stack[stackCount++] = tree->root;
+		while (stackCount > 0) {
+			const PhysicsTreeNode *node = tree->nodes + stack[--stackCount];
+			if (!AABBOverlap(node->aabb, aabb)) {
+				continue;
+			}
+			if (PhysicsTreeNodeIsLeaf(node)) {
+				visitor(physics, node->body, data);
+			} else {
+				Assert(stackCount + 2 <= PHYSICS_TREE_MAX_STACK_COUNT);
+				stack[stackCount++] = node->child1;
+				stack[stackCount++] = node->child2;
+			}
+		}
+	} else {
+		for (U32 bodyIndex = 0; bodyIndex < physics->bodyCount; ++bodyIndex) {
+			Body *body = physics->bodies[bodyIndex];
+			if (AABBOverlap(PhysicsQueryBodyBounds(physics, body), aabb)) {
+				visitor(physics, body, data);
+			}
+		}
+	}
+}
+
+//
+// Raycast
+//
+
+// NOTE(final): Walks the tiles along the ray, the first solid tile is the hit. Rays starting inside a solid tile are no hit.
+internal TOIResult PhysicsTilesRaycast(const PhysicsTileMap *tileMap, const Vec2f &origin, const Vec2f &translation) {
+	TOIResult result = {};
+	if (tileMap->solidCount == 0) {
+		return(result);
+	}
+	Vec2f tileSize = tileMap->tileSize;
+	S32 tile[2] = { FloorF32ToS32(origin.x / tileSize.x), FloorF32ToS32(origin.y / tileSize.y) };
+	if (PhysicsTileMapGet(tileMap, tile[0], tile[1]) & PHYSICS_TILE_SOLID) {
+		return(result);
+	}
+	S32 tileStep[2];
+	F32 nextTime[2];
+	F32 stepTime[2];
+	for (U32 axis = 0; axis < 2; ++axis) {
+		F32 axisTranslation = translation.p[axis];
+		if (axisTranslation > 0) {
+			tileStep[axis] = 1;
+			nextTime[axis] = ((F32)(tile[axis] + 1) * tileSize.p[axis] - origin.p[axis]) / axisTranslation;
+			stepTime[axis] = tileSize.p[axis] / axisTranslation;
+		} else if (axisTranslation < 0) {
+			tileStep[axis] = -1;
+			nextTime[axis] = ((F32)tile[axis] * tileSize.p[axis] - origin.p[axis]) / axisTranslation;
+			stepTime[axis] = -tileSize.p[axis] / axisTranslation;
+		} else {
+			tileStep[axis] = 0;
+			nextTime[axis] = FLT_MAX;
+			stepTime[axis] = FLT_MAX;
+		}
+	}
+	for (;;) {
+		U32 axis = nextTime[0] < nextTime[1] ? 0 : 1;
+		F32 time = nextTime[axis];
+		if (time > 1.0f) {
+			break;
+		}
+		tile[axis] += tileStep[axis];
+		if (PhysicsTileMapGet(tileMap, tile[0], tile[1]) & PHYSICS_TILE_SOLID) {
+			result.hit = true;
+			result.time = time;
+			result.normal.p[axis] = -(F32)tileStep[axis];
+			break;
+		}
+		nextTime[axis] += stepTime[axis];
+	}
+	return(result);
+}
+
+// NOTE(final): Rays of one packet in SoA layout, lanes without a ray have a negative max fraction so they never enter any bounds.
+//				The max fraction of a lane shrinks to its closest hit, so bounds behind the hit are skipped.
+struct PhysicsRayPacket {
+	F32 originX[PHYSICS_QUERY_LANE_COUNT];
+	F32 originY[PHYSICS_QUERY_LANE_COUNT];
+	F32 invTranslationX[PHYSICS_QUERY_LANE_COUNT];
+	F32 invTranslationY[PHYSICS_QUERY_LANE_COUNT];
+	F32 maxFractions[PHYSICS_QUERY_LANE_COUNT];
+	const PhysicsRayInput *rays;
+	PhysicsQueryHit *hits;
+};
+
+// NOTE(final): Translations close to zero are replaced by a large inverse, so the slab test never multiplies zero with infinity
+inline F32 PhysicsRayInvTranslation(F32 translation) {
+	F32 result = Abs(translation) > 1e-12f ? 1.0f / translation : 1e12f;
+	return(result);
+}
+
+// NOTE(final): Slab test of all rays against the bounds, returns the mask of the lanes which enter the bounds before their max fraction
+inline U32 PhysicsRayPacketOverlap(const PhysicsRayPacket *packet, const AABB &aabb) {
+	__m128 originX = _mm_loadu_ps(packet->originX);
+	__m128 originY = _mm_loadu_ps(packet->originY);
+	__m128 invX = _mm_loadu_ps(packet->invTranslationX);
+	__m128 invY = _mm_loadu_ps(packet->invTranslationY);
+	__m128 minX = _mm_mul_ps(_mm_sub_ps(_mm_set1_ps(aabb.min.x), originX), invX);
+	__m128 maxX = _mm_mul_ps(_mm_sub_ps(_mm_set1_ps(aabb.max.x), originX), invX);
+	__m128 minY = _mm_mul_ps(_mm_sub_ps(_mm_set1_ps(aabb.min.y), originY), invY);
+	__m128 maxY = _mm_mul_ps(_mm_sub_ps(_mm_set1_ps(aabb.max.y), originY), invY);
+	__m128 enter = _mm_max_ps(_mm_max_ps(_mm_min_ps(minX, maxX), _mm_min_ps(minY, maxY)), _mm_setzero_ps());
+	__m128 exit = _mm_min_ps(_mm_min_ps(_mm_max_ps(minX, maxX), _mm_max_ps(minY, maxY)), _mm_loadu_ps(packet->maxFractions));
+	U32 result = (U32)_mm_movemask_ps(_mm_cmple_ps(enter, exit));
+	return(result);
+}
+
+internal void PhysicsRayPacketTestBody(const Physics *physics, PhysicsRayPacket *packet, U32 laneMask, Body *body) {
+	Transform transform = PhysicsQueryBodyTransform(physics, body);
+	for (U32 lane = 0; lane < PHYSICS_QUERY_LANE_COUNT; ++lane) {
+		if (!(laneMask & (1 << lane))) {
+			continue;
+		}
+		const PhysicsRayInput *ray = packet->rays + lane;
+		if (!PhysicsQueryShouldHit(physics, ray->filter, ray->includeSensors, body)) {
+			continue;
+		}
+		TOIResult impact = RaycastShape(&body->shape, transform, ray->origin, ray->translation, packet->maxFractions[lane]);
+		if (impact.hit) {
+			PhysicsQueryHit *hit = packet->hits + lane;
+			hit->hit = true;
+			hit->body = body;
+			hit->fraction = impact.time;
+			hit->point = ray->origin + ray->translation * impact.time;
+			hit->normal = impact.normal;
+			packet->maxFractions[lane] = impact.time;
+		}
+	}
+}
+
+// NOTE(final): The tiles are walked first for every ray, so the bodies behind the first tile are never tested
+internal void PhysicsRaycastPacket(const Physics *physics, const PhysicsRayInput *rays, U32 rayCount, PhysicsQueryHit *hits) {
+	Assert(rayCount <= PHYSICS_QUERY_LANE_COUNT);
+	PhysicsRayPacket packet;
+	packet.rays = rays;
+	packet.hits = hits;
+	for (U32 lane = 0; lane < PHYSICS_QUERY_LANE_COUNT; ++lane) {
+		if (lane >= rayCount) {
+			packet.originX[lane] = 0;
+			packet.originY[lane] = 0;
+			packet.invTranslationX[lane] = 0;
+			packet.invTranslationY[lane] = 0;
+			packet.maxFractions[lane] = -1.0f;
+			continue;
+		}
+		const PhysicsRayInput *ray = rays + lane;
+		PhysicsQueryHit *hit = hits + lane;
+		*hit = {};
+		packet.originX[lane] = ray->origin.x;
+		packet.originY[lane] = ray->origin.y;
+		packet.invTranslationX[lane] = PhysicsRayInvTranslation(ray->translation.x);
+		packet.invTranslationY[lane] = PhysicsRayInvTranslation(ray->translation.y);
+		packet.maxFractions[lane] = 1.0f;
+		if (PhysicsFilterShouldCollide(ray->filter, physics->tileBody.filter)) {
+			TOIResult impact = PhysicsTilesRaycast(&physics->tileMap, ray->origin, ray->translation);
+			if (impact.hit) {
+				hit->hit = true;
+				hit->fraction = impact.time;
+				hit->point = ray->origin + ray->translation * impact.time;
+				hit->normal = impact.normal;
+				packet.maxFractions[lane] = impact.time;
+			}
+		}
+	}
+
+	const PhysicsTree *tree = &physics->tree;
+	if (physics->broadphaseType == PhysicsBroadphaseType::PhysicsBroadphaseType_Tree) {
+		if (tree->root == PHYSICS_TREE_NULL_NODE) {
+			return;
+		}
+		U32 stack[PHYSICS_TREE_MAX_STACK_COUNT];
+		U32 stackCount = 0;
+		stack[stackCount++] = tree->root;
+		while (stackCount > 0) {
+			const PhysicsTreeNode *node = tree->nodes + stack[--stackCount];
+			U32 laneMask = PhysicsRayPacketOverlap(&packet, node->aabb);
+			if (!laneMask) {
+				continue;
+			}
+			if (PhysicsTreeNodeIsLeaf(node)) {
+				PhysicsRayPacketTestBody(physics, &packet, laneMask, node->body);
+			} else {
+				Assert(stackCount + 2 <= PHYSICS_TREE_MAX_STACK_COUNT);
+				stack[stackCount++] = node->child1;
+				stack[stackCount++] = node->child2;
+			}
+		}
+	} else {
+		for (U32 bodyIndex = 0; bodyIndex < physics->bodyCount; ++bodyIndex) {
+			Body *body = physics->bodies[bodyIndex];
+			U32 laneMask = PhysicsRayPacketOverlap(&packet, PhysicsQueryBodyBounds(physics, body));
+			if (laneMask) {
+				PhysicsRayPacketTestBody(physics, &packet, laneMask, body);
+			}
+		}
+	}
+}
+
+// NOTE(final): Consecutive rays are packed together, so rays which are close to each other should be next to each other in the batch
+external void PhysicsRaycastBatch(const Physics *physics, const PhysicsRayInput *rays, U32 rayCount, PhysicsQueryHit *outHits) {
+	for (U32 rayStart = 0; rayStart < rayCount; rayStart += PHYSICS_QUERY_LANE_COUNT) {
+		U32 packetCount = Min(PHYSICS_QUERY_LANE_COUNT, rayCount - rayStart);
+		PhysicsRaycastPacket(physics, rays + rayStart, packetCount, outHits + rayStart);
+	}
+}
+
+//
+// AABB query
+//
+
+struct PhysicsAABBQueryState {
+	const PhysicsAABBQueryInput *query;
+	PhysicsAABBQueryResult *result;
+	Body **outBodies;
+	U32 *outBodyCount;
+	U32 maxBodyCount;
+};
+
+internal PHYSICS_QUERY_VISITOR(PhysicsAABBQueryVisit) {
+	PhysicsAABBQueryState *state = (PhysicsAABBQueryState *)data;
+	if (!PhysicsQueryShouldHit(physics, state->query->filter, state->query->includeSensors, body) || !AABBOverlap(PhysicsQueryBodyBounds(physics, body), state->query->aabb)) {
+		return;
+	}
+	if (*state->outBodyCount < state->maxBodyCount) {
+		state->outBodies[(*state->outBodyCount)++] = body;
+		++state->result->bodyCount;
+	} else {
+		state->result->isTruncated = true;
+	}
+}
+
+internal B32 PhysicsTilesOverlap(const PhysicsTileMap *tileMap, const AABB &aabb) {
+	if (tileMap->solidCount == 0) {
+		return(false);
+	}
+	S32 minTileX = FloorF32ToS32(aabb.min.x / tileMap->tileSize.x);
+	S32 minTileY = FloorF32ToS32(aabb.min.y / tileMap->tileSize.y);
+	S32 maxTileX = FloorF32ToS32(aabb.max.x / tileMap->tileSize.x);
+	S32 maxTileY = FloorF32ToS32(aabb.max.y / tileMap->tileSize.y);
+	for (S32 tileY = minTileY; tileY <= maxTileY; ++tileY) {
+		for (S32 tileX = minTileX; tileX <= maxTileX; ++tileX) {
+			if (PhysicsTileMapGet(tileMap, tileX, tileY) & PHYSICS_TILE_SOLID) {
+				return(true);
+			}
+		}
+	}
+	return(false);
+}
+
+// NOTE(final): Bodies of all queries are written into the same body output, each result is the range of its query
+external void PhysicsAABBQuery(const Physics *physics, const PhysicsAABBQueryInput *queries, U32 queryCount, Body **outBodies, U32 maxBodyCount, PhysicsAABBQueryResult *outResults) {
+	U32 outBodyCount = 0;
+	for (U32 queryIndex = 0; queryIndex < queryCount; ++queryIndex) {
+		const PhysicsAABBQueryInput *query = queries + queryIndex;
+		PhysicsAABBQueryResult *result = outResults + queryIndex;
+		*result = {};
+		result->bodyStart = outBodyCount;
+		result->overlapsTiles = PhysicsFilterShouldCollide(query->filter, physics->tileBody.filter) && PhysicsTilesOverlap(&physics->tileMap, query->aabb);
+
+		PhysicsAABBQueryState state;
+		state.query = query;
+		state.result = result;
+		state.outBodies = outBodies;
+		state.outBodyCount = &outBodyCount;
+		state.maxBodyCount = maxBodyCount;
+		PhysicsQueryOverlaps(physics, query->aabb, PhysicsAABBQueryVisit, &state);
+	}
+}
+
+//
+// Shape cast
+//
+
+struct PhysicsShapeCastState {
+	Shape *shape;
+	Transform transform;
+	Vec2f translation;
+	AABB sweptBounds;
+	PhysicsFilter filter;
+	B32 includeSensors;
+	PhysicsQueryHit *hit;
+};
+
+internal PHYSICS_QUERY_VISITOR(PhysicsShapeCastVisit) {
+	PhysicsShapeCastState *state = (PhysicsShapeCastState *)data;
+	if (!PhysicsQueryShouldHit(physics, state->filter, state->includeSensors, body) || !AABBOverlap(PhysicsQueryBodyBounds(physics, body), state->sweptBounds)) {
+		return;
+	}
+	TOIResult impact = QueryTOI(state->shape, state->transform, state->translation, &body->shape, PhysicsQueryBodyTransform(physics, body), PHYSICS_LINEAR_SLOP);
+	PhysicsQueryHit *hit = state->hit;
+	if (impact.hit && (!hit->hit || impact.time < hit->fraction)) {
+		hit->hit = true;
+		hit->body = body;
+		hit->fraction = impact.time;
+		hit->normal = -impact.normal;
+	}
+}
+
+// NOTE(final): The shape is copied and cooked, so the caller does not need to cook it
+external void PhysicsShapeCast(const Physics *physics, const PhysicsShapeCastInput *casts, U32 castCount, PhysicsQueryHit *outHits) {
+	for (U32 castIndex = 0; castIndex < castCount; ++castIndex) {
+		const PhysicsShapeCastInput *cast = casts + castIndex;
+		PhysicsQueryHit *hit = outHits + castIndex;
+		*hit = {};
+		Assert(cast->shape->type != ShapeType::ShapeType_Plane);
+		Shape shape = *cast->shape;
+		CookShape(&shape, shape.material.density);
+		Vec2f radius = PhysicsShapeGetExtents(shape);
+
+		if (PhysicsFilterShouldCollide(cast->filter, physics->tileBody.filter)) {
+			Vec2f sweepRadius = radius + V2(PHYSICS_LINEAR_SLOP, PHYSICS_LINEAR_SLOP);
+			TOIResult impact = PhysicsTilesFirstImpact(&physics->tileMap, cast->position, sweepRadius, cast->translation);
+			if (impact.hit) {
+				hit->hit = true;
+				hit->fraction = impact.time;
+				hit->normal = -impact.normal;
+			}
+		}
+
+		PhysicsShapeCastState state;
+		state.shape = &shape;
+		state.transform = TransformMult(shape.localTransform, TransformMakeTranslation(cast->position));
+		state.translation = cast->translation;
+		state.sweptBounds = AABBCombine(AABBFromCenterExt(cast->position, radius), AABBFromCenterExt(cast->position + cast->translation, radius));
+		state.filter = cast->filter;
+		state.includeSensors = cast->includeSensors;
+		state.hit = hit;
+		PhysicsQueryOverlaps(physics, state.sweptBounds, PhysicsShapeCastVisit, &state);
+
+		if (hit->hit) {
+			hit->point = cast->position + cast->translation * hit->fraction;
+		}
+	}
+}
\ No newline at end of file
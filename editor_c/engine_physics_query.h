@@ -0,0 +1,60 @@
+#pragma once
+
+#include "engine_types.h"
+#include "engine_math.h"
+#include "engine_physics.h"
+
+// NOTE(final): Queries only read the physics state, so any number of job threads can run them at once, but never while a step is running.
+//				Bodies are found by the tree when it is the broadphase, otherwise all bodies are tested.
+//				Sensors are skipped unless the query includes them, so triggers and pickups never block a line of sight or a ground check.
+
+// NOTE(final): Rays are answered in packets, every bounds is tested against all rays of a packet at once
+constant U32 PHYSICS_QUERY_LANE_COUNT = 4;
+
+// NOTE(final): Ray from the origin along the translation, only bodies and tiles which pass the filter are hit
+struct PhysicsRayInput {
+	Vec2f origin;
+	Vec2f translation;
+	PhysicsFilter filter;
+	B32 includeSensors;
+};
+
+struct PhysicsAABBQueryInput {
+	AABB aabb;
+	PhysicsFilter filter;
+	B32 includeSensors;
+};
+
+// NOTE(final): The shape moves from the position along the translation and stops at the linear slop before the first impact.
+//				Tiles are hit by the shape bounds like in the contacts.
+struct PhysicsShapeCastInput {
+	const Shape *shape;
+	Vec2f position;
+	Vec2f translation;
+	PhysicsFilter filter;
+	B32 includeSensors;
+};
+
+// NOTE(final): Closest hit of a ray or a shape cast, the fraction is in the range of zero to one of the translation.
+//				The body is null when a tile was hit. The normal is the surface normal at the hit, which points against the translation.
+//				The point is the hit point for rays and the shape position at the impact for shape casts.
+struct PhysicsQueryHit {
+	B32 hit;
+	Body *body;
+	F32 fraction;
+	Vec2f point;
+	Vec2f normal;
+};
+
+// NOTE(final): Range of the bodies a single query has written into the body output of the batch
+struct PhysicsAABBQueryResult {
+	U32 bodyStart;
+	U32 bodyCount;
+	B32 overlapsTiles;
+	// NOTE(final): The body output was full, so not all bodies of this query have been written
+	B32 isTruncated;
+};
+
+external void PhysicsRaycastBatch(const Physics *physics, const PhysicsRayInput *rays, U32 rayCount, PhysicsQueryHit *outHits);
+external void PhysicsAABBQuery(const Physics *physics, const PhysicsAABBQueryInput *queries, U32 queryCount, Body **outBodies, U32 maxBodyCount, PhysicsAABBQueryResult *outResults);
+external void PhysicsShapeCast(const Physics *physics, const PhysicsShapeCastInput *casts, U32 castCount, PhysicsQueryHit *outHits);
\ No newline at end of file
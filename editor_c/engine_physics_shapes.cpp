@@ -0,0 +1,103 @@
+#include "engine_physics_shapes.h"
+
+// NOTE(final): Computes everything which only depends on the vertices, so the narrowphase never normalizes an edge
+internal void CookEdgeShape(EdgeShape *edge) {
+	U32 vertexCount = edge->vertexCount;
+	Assert(vertexCount >= 2);
+	edge->localBounds = AABBFromMinMax(edge->localVerts[0], edge->localVerts[0]);
+	edge->boundingRadius = 0;
+	for (U32 vertexIndex = 0; vertexIndex < vertexCount; ++vertexIndex) {
+		Vec2f v0 = edge->localVerts[vertexIndex];
+		Vec2f v1 = edge->localVerts[(vertexIndex + 1) % vertexCount];
+		Vec2f t = Vec2Normalize(v1 - v0);
+		Vec2f n = Vec2Cross(t, 1.0f);
+		edge->localNormals[vertexIndex] = n;
+		edge->localNormalsX[vertexIndex] = n.x;
+		edge->localNormalsY[vertexIndex] = n.y;
+		edge->localBounds.min = Vec2Min(edge->localBounds.min, v0);
+		edge->localBounds.max = Vec2Max(edge->localBounds.max, v0);
+		F32 vertexDistance = Vec2Length(v0);
+		edge->boundingRadius = Max(edge->boundingRadius, vertexDistance);
+	}
+	for (U32 vertexIndex = vertexCount; vertexIndex < PHYSICS_MAX_EDGE_SHAPE_VERTEX_COUNT; ++vertexIndex) {
+		edge->localNormals[vertexIndex] = V2();
+		edge->localNormalsX[vertexIndex] = 0;
+		edge->localNormalsY[vertexIndex] = 0;
+	}
+}
+
+// NOTE(final): Area, centroid and inertia of a convex polygon as a sum of triangles.
+//				The triangles are built from the first vertex to reduce the round-off error.
+internal ShapeMassData ComputePolygonMass(const EdgeShape *edge, F32 density) {
+	ShapeMassData result = {};
+	U32 vertexCount = edge->vertexCount;
+	Vec2f reference = edge->localVerts[0];
+	Vec2f center = V2();
+	F32 area = 0;
+	F32 inertia = 0;
+	const F32 inv3 = 1.0f / 3.0f;
+	for (U32 vertexIndex = 1; vertexIndex < vertexCount - 1; ++vertexIndex) {
+		Vec2f e1 = edge->localVerts[vertexIndex] - reference;
+		Vec2f e2 = edge->localVerts[vertexIndex + 1] - reference;
+		F32 d = Vec2Cross(e1, e2);
+		F32 triangleArea = 0.5f * d;
+		area += triangleArea;
+		center += (e1 + e2) * (triangleArea * inv3);
+		F32 intX2 = e1.x * e1.x + e2.x * e1.x + e2.x * e2.x;
+		F32 intY2 = e1.y * e1.y + e2.y * e1.y + e2.y * e2.y;
+		inertia += (0.25f * inv3 * d) * (intX2 + intY2);
+	}
+	if (area > 0) {
+		center *= 1.0f / area;
+		result.mass = area * density;
+		result.centroid = reference + center;
+		// NOTE(final): Inertia is around the reference vertex, so it is shifted to the centroid
+		result.inertia = density * inertia - result.mass * Vec2Dot(center, center);
+	} else {
+		result.centroid = reference;
+	}
+	return(result);
+}
+
+internal ShapeKind GetEdgeShapeKind(ShapeType type, U32 vertexCount) {
+	ShapeKind result = ShapeKind::ShapeKind_Polygon;
+	if (type == ShapeType::ShapeType_LineSegment) {
+		result = ShapeKind::ShapeKind_LineSegment;
+	} else if (type == ShapeType::ShapeType_Box) {
+		result = ShapeKind::ShapeKind_Box;
+	} else if (vertexCount >= 3 && vertexCount <= PHYSICS_MAX_FIXED_POLYGON_VERTEX_COUNT) {
+		result = (ShapeKind)(ShapeKind::ShapeKind_Polygon3 + (vertexCount - 3));
+	}
+	return(result);
+}
+
+external void CookShape(Shape *shape, F32 density) {
+	shape->material.density = density;
+	shape->massData = {};
+	switch (shape->type) {
+		case ShapeType::ShapeType_Circle:
+		{
+			shape->kind = ShapeKind::ShapeKind_Circle;
+			F32 radius = shape->circle.radius;
+			shape->massData.mass = PI32 * radius * radius * density;
+			shape->massData.inertia = shape->massData.mass * 0.5f * radius * radius;
+		}; break;
+		case ShapeType::ShapeType_Plane:
+		{
+			shape->kind = ShapeKind::ShapeKind_Plane;
+		}; break;
+		case ShapeType::ShapeType_LineSegment:
+		case ShapeType::ShapeType_Box:
+		case ShapeType::ShapeType_Polygon:
+		{
+			EdgeShape *edge = GetEdgeShape(shape);
+			CookEdgeShape(edge);
+			shape->kind = GetEdgeShapeKind(shape->type, edge->vertexCount);
+			edge->isBox = shape->type == ShapeType::ShapeType_Box;
+			if (shape->type != ShapeType::ShapeType_LineSegment) {
+				shape->massData = ComputePolygonMass(edge, density);
+			}
+		}; break;
+		InvalidDefaultCase;
+	}
+}
\ No newline at end of file
@@ -4,6 +4,7 @@
 #include "engine_math.h"
 
 constant U32 PHYSICS_MAX_EDGE_SHAPE_VERTEX_COUNT = 16;
+constant U32 PHYSICS_EDGE_SHAPE_NULL_VERTEX = 0xFFFFFFFF;
 
 enum ShapeType {
 	ShapeType_None = 0,
@@ -17,6 +18,29 @@ enum ShapeType {
 	ShapeType_Count,
 };
 
+// NOTE(final): Shape type together with the vertex count of small polygons, the contact generators are specialized on both.
+//				Same order as the shape types, so planes come first and circles last.
+enum ShapeKind {
+	ShapeKind_None = 0,
+
+	ShapeKind_Plane,
+	ShapeKind_LineSegment,
+	ShapeKind_Box,
+	// NOTE(final): Polygon with any vertex count
+	ShapeKind_Polygon,
+	ShapeKind_Polygon3,
+	ShapeKind_Polygon4,
+	ShapeKind_Polygon5,
+	ShapeKind_Polygon6,
+	ShapeKind_Polygon7,
+	ShapeKind_Polygon8,
+	ShapeKind_Circle,
+
+	ShapeKind_Count,
+};
+
+constant U32 PHYSICS_MAX_FIXED_POLYGON_VERTEX_COUNT = 8;
+
 struct PlaneShape {
 	F32 len;
 	// NOTE(final): Normal is computed on the fly based on the local and world rotation
@@ -24,7 +48,19 @@ struct PlaneShape {
 
 struct EdgeShape {
 	Vec2f localVerts[PHYSICS_MAX_EDGE_SHAPE_VERTEX_COUNT];
+	// NOTE(final): Same vertices in SoA layout for the SIMD kernels, the max vertex count is a multiple of four so no load goes past the arrays
+	F32 localVertsX[PHYSICS_MAX_EDGE_SHAPE_VERTEX_COUNT];
+	F32 localVertsY[PHYSICS_MAX_EDGE_SHAPE_VERTEX_COUNT];
 	U32 vertexCount;
+
+	// NOTE(final): Cooked by CookShape. The normal of edge i points outwards from the vertex i to the vertex i + 1.
+	Vec2f localNormals[PHYSICS_MAX_EDGE_SHAPE_VERTEX_COUNT];
+	F32 localNormalsX[PHYSICS_MAX_EDGE_SHAPE_VERTEX_COUNT];
+	F32 localNormalsY[PHYSICS_MAX_EDGE_SHAPE_VERTEX_COUNT];
+	AABB localBounds;
+	F32 boundingRadius;
+	// NOTE(final): Boxes are tested on their two axis only, instead of testing all four edges
+	B32 isBox;
 };
 
 struct LineSegmentShape : EdgeShape {
@@ -47,11 +83,22 @@ struct PhysicsMaterial {
 	F32 friction;
 };
 
+// NOTE(final): Cooked by CookShape, static shapes like planes and line segments have no mass
+struct ShapeMassData {
+	F32 mass;
+	// NOTE(final): Rotational inertia around the centroid
+	F32 inertia;
+	Vec2f centroid;
+};
+
 struct Shape {
 	U32 shapeId;
 	Transform localTransform;
 	PhysicsMaterial material;
+	ShapeMassData massData;
 	ShapeType type;
+	// NOTE(final): Set by CookShape
+	ShapeKind kind;
 	union {
 		PlaneShape plane;
 		LineSegmentShape lineSegment;
@@ -91,4 +138,65 @@ inline EdgeShape *GetEdgeShape(Shape *shape) {
 	InvalidDefaultCase;
 	}
 	return (result);
-}
\ No newline at end of file
+}
+
+inline void SetEdgeShapeVertices(EdgeShape *edge, U32 vertexCount, const Vec2f *verts) {
+	Assert(vertexCount <= PHYSICS_MAX_EDGE_SHAPE_VERTEX_COUNT);
+	edge->vertexCount = vertexCount;
+	for (U32 vertexIndex = 0; vertexIndex < vertexCount; ++vertexIndex) {
+		edge->localVerts[vertexIndex] = verts[vertexIndex];
+		edge->localVertsX[vertexIndex] = verts[vertexIndex].x;
+		edge->localVertsY[vertexIndex] = verts[vertexIndex].y;
+	}
+}
+
+inline Shape MakeCircleShape(F32 radius) {
+	Shape result = {};
+	result.type = ShapeType::ShapeType_Circle;
+	result.localTransform = TransformIdentity();
+	result.material = MakePhysicsMaterial();
+	result.circle.radius = radius;
+	return(result);
+}
+
+// NOTE(final): Box shapes are always centered and axis aligned to the body and keep the identity local transform, which body creation asserts.
+//				Use a polygon shape for an offset or rotated box.
+inline Shape MakeBoxShape(const Vec2f &extend) {
+	Shape result = {};
+	result.type = ShapeType::ShapeType_Box;
+	result.localTransform = TransformIdentity();
+	result.material = MakePhysicsMaterial();
+	result.box.extend = extend;
+	Vec2f verts[4] = {
+		V2(-extend.x, -extend.y),
+		V2(extend.x, -extend.y),
+		V2(extend.x, extend.y),
+		V2(-extend.x, extend.y),
+	};
+	SetEdgeShapeVertices(&result.box, 4, verts);
+	return(result);
+}
+
+// NOTE(final): Vertices must be convex and in counter clockwise order
+inline Shape MakePolygonShape(U32 vertexCount, const Vec2f *verts) {
+	Assert(vertexCount >= 3 && vertexCount <= PHYSICS_MAX_EDGE_SHAPE_VERTEX_COUNT);
+	Shape result = {};
+	result.type = ShapeType::ShapeType_Polygon;
+	result.localTransform = TransformIdentity();
+	result.material = MakePhysicsMaterial();
+	SetEdgeShapeVertices(&result.polygon, vertexCount, verts);
+	return(result);
+}
+
+// NOTE(final): The normal of the plane is the first axis of the local rotation, the length is used for the bounds only
+inline Shape MakePlaneShape(F32 len, const Vec2f &normal) {
+	Shape result = {};
+	result.type = ShapeType::ShapeType_Plane;
+	result.localTransform = TransformIdentity();
+	result.localTransform.rot = Mat2RotationFromAxis(normal);
+	result.material = StaticMaterial();
+	result.plane.len = len;
+	return(result);
+}
+
+external void CookShape(Shape *shape, F32 density);
\ No newline at end of file
@@ -0,0 +1,345 @@
+#include "engine_physics_solver.h"
+
+#include "engine_physics.h"
+
+#include <xmmintrin.h>
+
+external void PhysicsSolverInit(PhysicsSolver *solver, MemoryBlock *memory, PhysicsSolverType type, U32 maxBodyCount) {
+	solver->type = type;
+	PhysicsSolverIterationsSet(solver, PHYSICS_MIN_SOLVER_ITERATION_COUNT, PHYSICS_MAX_SOLVER_ITERATION_COUNT, PHYSICS_SOLVER_VELOCITY_TOLERANCE);
+	solver->batches = 0;
+	solver->overflowContacts = 0;
+	solver->contactColors = 0;
+	solver->colorStarts = PushArray(memory, U32, PHYSICS_SOLVER_MAX_COLOR_COUNT + 1);
+	solver->sortedContacts = 0;
+	solver->bodyColorMasks = PushArray(memory, U32, maxBodyCount);
+	solver->batchCount = 0;
+	solver->overflowCount = 0;
+	solver->colorCount = 0;
+}
+
+// NOTE(final): Effective masses are computed once per step, instead of once per contact and iteration
+external void PhysicsSolverPrepare(Physics *physics) {
+	for (U32 contactIndex = 0; contactIndex < physics->contactCount; ++contactIndex) {
+		Contact *contact = physics->contacts + contactIndex;
+		contact->invMassA = physics->bodyData.invMasses[contact->bodyA->index];
+		contact->invMassB = physics->bodyData.invMasses[contact->bodyB->index];
+		F32 invMassSum = contact->invMassA + contact->invMassB;
+		contact->massNormal = invMassSum > 0 ? 1.0f / invMassSum : 0;
+		contact->bias = 0;
+	}
+}
+
+// NOTE(final): Returns the change of the relative normal velocity, which is used for the early exit
+inline F32 PhysicsSolverContactVelocity(Vec2f *velocities, Contact *contact, F32 invDeltaTime) {
+	Vec2f *velA = velocities + contact->bodyA->index;
+	Vec2f *velB = velocities + contact->bodyB->index;
+
+	// Get relative velocity
+	Vec2f relVel = *velB - *velA;
+
+	// Calculate impulse, penetration is resolved by the position solver
+	F32 remove = Vec2Dot(relVel, contact->normal) + Max(contact->distance, 0) * invDeltaTime;
+	F32 impulse = remove * contact->massNormal;
+
+	// Accumulate impulse
+	F32 newImpulse = Min(impulse + contact->normalImpulse, 0);
+	impulse = newImpulse - contact->normalImpulse;
+	contact->normalImpulse = newImpulse;
+
+	// Apply impulses
+	*velA += contact->normal * impulse * contact->invMassA;
+	*velB -= contact->normal * impulse * contact->invMassB;
+
+	F32 result = Abs(impulse) * (contact->invMassA + contact->invMassB);
+	return(result);
+}
+
+// NOTE(final): Solves penetration on the bias velocity only (split impulse).
+//				This impulse is not warm started, otherwise the push out is carried into the next step and stacks start to jitter.
+inline F32 PhysicsSolverContactPosition(Vec2f *biasVelocities, Contact *contact, F32 invDeltaTime) {
+	if (contact->distance >= -PHYSICS_LINEAR_SLOP) {
+		return(0);
+	}
+	Vec2f *velA = biasVelocities + contact->bodyA->index;
+	Vec2f *velB = biasVelocities + contact->bodyB->index;
+
+	Vec2f relVel = *velB - *velA;
+
+	F32 remove = Vec2Dot(relVel, contact->normal) + (contact->distance + PHYSICS_LINEAR_SLOP) * PHYSICS_BAUMGARTE_FACTOR * invDeltaTime;
+	F32 impulse = remove * contact->massNormal;
+
+	F32 newImpulse = Min(impulse + contact->bias, 0);
+	impulse = newImpulse - contact->bias;
+	contact->bias = newImpulse;
+
+	*velA += contact->normal * impulse * contact->invMassA;
+	*velB -= contact->normal * impulse * contact->invMassB;
+
+	F32 result = Abs(impulse) * (contact->invMassA + contact->invMassB);
+	return(result);
+}
+
+external void PhysicsSolverSolveScalar(Physics *physics, const U32 *contactIndices, U32 contactCount, F32 deltaTime) {
+	const PhysicsSolver *solver = &physics->solver;
+	F32 invDeltaTime = 1.0f / deltaTime;
+	for (U32 iteration = 0; iteration < solver->maxIterationCount; iteration++) {
+		F32 maxVelocityChange = 0;
+		for (U32 index = 0; index < contactCount; index++) {
+			F32 velocityChange = PhysicsSolverContactVelocity(physics->bodyData.velocities, physics->contacts + contactIndices[index], invDeltaTime);
+			maxVelocityChange = Max(maxVelocityChange, velocityChange);
+		}
+		++physics->stats.solverVelocityIterationCount;
+		if (iteration + 1 >= solver->minIterationCount && maxVelocityChange < solver->velocityTolerance) {
+			break;
+		}
+	}
+	for (U32 iteration = 0; iteration < solver->maxIterationCount; iteration++) {
+		F32 maxVelocityChange = 0;
+		for (U32 index = 0; index < contactCount; index++) {
+			F32 velocityChange = PhysicsSolverContactPosition(physics->bodyData.biasVelocities, physics->contacts + contactIndices[index], invDeltaTime);
+			maxVelocityChange = Max(maxVelocityChange, velocityChange);
+		}
+		++physics->stats.solverPositionIterationCount;
+		if (iteration + 1 >= solver->minIterationCount && maxVelocityChange < solver->velocityTolerance) {
+			break;
+		}
+	}
+}
+
+// NOTE(final): Greedy graph coloring, a color is never used twice by the same dynamic body.
+//				Static bodies have no mass, so they are shared between any number of contacts of the same color.
+//				The per contact arrays and the batches are taken from the step memory.
+external void PhysicsSolverColor(Physics *physics, PhysicsSolver *solver, MemoryBlock *stepMemory) {
+	solver->batchCount = 0;
+	solver->overflowCount = 0;
+	solver->colorCount = 0;
+	if (physics->contactCount == 0) {
+		return;
+	}
+	solver->contactColors = PushArray(stepMemory, U32, physics->contactCount, MemoryFlag::MemoryFlag_None);
+	solver->overflowContacts = PushArray(stepMemory, U32, physics->contactCount, MemoryFlag::MemoryFlag_None);
+	solver->sortedContacts = PushArray(stepMemory, U32, physics->contactCount, MemoryFlag::MemoryFlag_None);
+
+	U32 *bodyColorMasks = solver->bodyColorMasks;
+	for (U32 contactIndex = 0; contactIndex < physics->contactCount; ++contactIndex) {
+		Contact *contact = physics->contacts + contactIndex;
+		if (contact->bodyA->islandIndex != PHYSICS_ISLAND_NULL) {
+			bodyColorMasks[contact->bodyA->islandIndex] = 0;
+		}
+		if (contact->bodyB->islandIndex != PHYSICS_ISLAND_NULL) {
+			bodyColorMasks[contact->bodyB->islandIndex] = 0;
+		}
+	}
+
+	U32 colorCounts[PHYSICS_SOLVER_MAX_COLOR_COUNT] = {};
+	for (U32 contactIndex = 0; contactIndex < physics->contactCount; ++contactIndex) {
+		Contact *contact = physics->contacts + contactIndex;
+		U32 indexA = contact->bodyA->islandIndex;
+		U32 indexB = contact->bodyB->islandIndex;
+		U32 usedColors = 0;
+		if (indexA != PHYSICS_ISLAND_NULL) {
+			usedColors |= bodyColorMasks[indexA];
+		}
+		if (indexB != PHYSICS_ISLAND_NULL) {
+			usedColors |= bodyColorMasks[indexB];
+		}
+		if (usedColors == 0xFFFFFFFF) {
+			solver->contactColors[contactIndex] = PHYSICS_SOLVER_MAX_COLOR_COUNT;
+			solver->overflowContacts[solver->overflowCount++] = contactIndex;
+			continue;
+		}
+		U32 color = 0;
+		while (usedColors & (1u << color)) {
+			++color;
+		}
+		if (indexA != PHYSICS_ISLAND_NULL) {
+			bodyColorMasks[indexA] |= 1u << color;
+		}
+		if (indexB != PHYSICS_ISLAND_NULL) {
+			bodyColorMasks[indexB] |= 1u << color;
+		}
+		solver->contactColors[contactIndex] = color;
+		++colorCounts[color];
+		solver->colorCount = Max(solver->colorCount, color + 1);
+	}
+
+	// NOTE(final): Counting sort of the contacts by color
+	U32 *colorStarts = solver->colorStarts;
+	colorStarts[0] = 0;
+	for (U32 color = 0; color < PHYSICS_SOLVER_MAX_COLOR_COUNT; ++color) {
+		colorStarts[color + 1] = colorStarts[color] + colorCounts[color];
+		colorCounts[color] = colorStarts[color];
+	}
+	for (U32 contactIndex = 0; contactIndex < physics->contactCount; ++contactIndex) {
+		U32 color = solver->contactColors[contactIndex];
+		if (color < PHYSICS_SOLVER_MAX_COLOR_COUNT) {
+			solver->sortedContacts[colorCounts[color]++] = contactIndex;
+		}
+	}
+
+	// NOTE(final): Pack each color into batches, a batch never mixes two colors
+	U32 maxBatchCount = 0;
+	for (U32 color = 0; color < solver->colorCount; ++color) {
+		maxBatchCount += (colorStarts[color + 1] - colorStarts[color] + PHYSICS_SOLVER_LANE_COUNT - 1) / PHYSICS_SOLVER_LANE_COUNT;
+	}
+	if (maxBatchCount > 0) {
+		solver->batches = PushArray(stepMemory, PhysicsSolverBatch, maxBatchCount, MemoryFlag::MemoryFlag_None);
+	}
+	for (U32 color = 0; color < solver->colorCount; ++color) {
+		for (U32 sortedIndex = colorStarts[color]; sortedIndex < colorStarts[color + 1]; sortedIndex += PHYSICS_SOLVER_LANE_COUNT) {
+			PhysicsSolverBatch *batch = solver->batches + solver->batchCount++;
+			batch->laneCount = Min(PHYSICS_SOLVER_LANE_COUNT, colorStarts[color + 1] - sortedIndex);
+			for (U32 lane = 0; lane < PHYSICS_SOLVER_LANE_COUNT; ++lane) {
+				if (lane < batch->laneCount) {
+					U32 contactIndex = solver->sortedContacts[sortedIndex + lane];
+					Contact *contact = physics->contacts + contactIndex;
+					batch->bodyIndicesA[lane] = contact->bodyA->index;
+					batch->bodyIndicesB[lane] = contact->bodyB->index;
+					batch->contactIndices[lane] = contactIndex;
+					batch->normalX[lane] = contact->normal.x;
+					batch->normalY[lane] = contact->normal.y;
+					batch->distance[lane] = contact->distance;
+					batch->invMassA[lane] = contact->invMassA;
+					batch->invMassB[lane] = contact->invMassB;
+					batch->massNormal[lane] = contact->massNormal;
+					batch->normalImpulse[lane] = contact->normalImpulse;
+				} else {
+					batch->bodyIndicesA[lane] = PHYSICS_TILE_BODY_INDEX;
+					batch->bodyIndicesB[lane] = PHYSICS_TILE_BODY_INDEX;
+					batch->contactIndices[lane] = PHYSICS_CONTACT_NULL;
+					batch->normalX[lane] = 0;
+					batch->normalY[lane] = 0;
+					batch->distance[lane] = 0;
+					batch->invMassA[lane] = 0;
+					batch->invMassB[lane] = 0;
+					batch->massNormal[lane] = 0;
+					batch->normalImpulse[lane] = 0;
+				}
+				batch->biasImpulse[lane] = 0;
+			}
+		}
+	}
+}
+
+// NOTE(final): Same math as the scalar contact solve, for four contacts at once.
+//				The position pass works on the bias velocity and masks out contacts which are not penetrating.
+//				Returns the largest change of the relative normal velocity of all four lanes.
+internal F32 PhysicsSolverBatchSolve(PhysicsSolverBatch *batch, Vec2f *velocities, B32 isPosition, F32 invDeltaTime) {
+	F32 velAX[PHYSICS_SOLVER_LANE_COUNT], velAY[PHYSICS_SOLVER_LANE_COUNT];
+	F32 velBX[PHYSICS_SOLVER_LANE_COUNT], velBY[PHYSICS_SOLVER_LANE_COUNT];
+	for (U32 lane = 0; lane < PHYSICS_SOLVER_LANE_COUNT; ++lane) {
+		Vec2f *velA = velocities + batch->bodyIndicesA[lane];
+		Vec2f *velB = velocities + batch->bodyIndicesB[lane];
+		velAX[lane] = velA->x;
+		velAY[lane] = velA->y;
+		velBX[lane] = velB->x;
+		velBY[lane] = velB->y;
+	}
+
+	__m128 zero = _mm_setzero_ps();
+	__m128 vAX = _mm_loadu_ps(velAX);
+	__m128 vAY = _mm_loadu_ps(velAY);
+	__m128 vBX = _mm_loadu_ps(velBX);
+	__m128 vBY = _mm_loadu_ps(velBY);
+	__m128 nX = _mm_loadu_ps(batch->normalX);
+	__m128 nY = _mm_loadu_ps(batch->normalY);
+	__m128 distance = _mm_loadu_ps(batch->distance);
+	__m128 massNormal = _mm_loadu_ps(batch->massNormal);
+	__m128 invMassA = _mm_loadu_ps(batch->invMassA);
+	__m128 invMassB = _mm_loadu_ps(batch->invMassB);
+	F32 *accumulatedPtr = isPosition ? batch->biasImpulse : batch->normalImpulse;
+	__m128 accumulated = _mm_loadu_ps(accumulatedPtr);
+
+	// Get relative normal velocity
+	__m128 relVel = _mm_add_ps(_mm_mul_ps(_mm_sub_ps(vBX, vAX), nX), _mm_mul_ps(_mm_sub_ps(vBY, vAY), nY));
+
+	// Calculate impulse
+	__m128 remove;
+	__m128 activeMask;
+	if (isPosition) {
+		__m128 slop = _mm_set1_ps(PHYSICS_LINEAR_SLOP);
+		__m128 factor = _mm_set1_ps(PHYSICS_BAUMGARTE_FACTOR * invDeltaTime);
+		remove = _mm_add_ps(relVel, _mm_mul_ps(_mm_add_ps(distance, slop), factor));
+		activeMask = _mm_cmplt_ps(distance, _mm_sub_ps(zero, slop));
+	} else {
+		remove = _mm_add_ps(relVel, _mm_mul_ps(_mm_max_ps(distance, zero), _mm_set1_ps(invDeltaTime)));
+		activeMask = _mm_cmpeq_ps(zero, zero);
+	}
+	__m128 impulse = _mm_mul_ps(remove, massNormal);
+
+	// Accumulate impulse
+	__m128 newImpulse = _mm_min_ps(_mm_add_ps(impulse, accumulated), zero);
+	impulse = _mm_and_ps(_mm_sub_ps(newImpulse, accumulated), activeMask);
+	accumulated = _mm_add_ps(accumulated, impulse);
+	_mm_storeu_ps(accumulatedPtr, accumulated);
+
+	// Apply impulses
+	__m128 impulseX = _mm_mul_ps(nX, impulse);
+	__m128 impulseY = _mm_mul_ps(nY, impulse);
+	vAX = _mm_add_ps(vAX, _mm_mul_ps(impulseX, invMassA));
+	vAY = _mm_add_ps(vAY, _mm_mul_ps(impulseY, invMassA));
+	vBX = _mm_sub_ps(vBX, _mm_mul_ps(impulseX, invMassB));
+	vBY = _mm_sub_ps(vBY, _mm_mul_ps(impulseY, invMassB));
+	_mm_storeu_ps(velAX, vAX);
+	_mm_storeu_ps(velAY, vAY);
+	_mm_storeu_ps(velBX, vBX);
+	_mm_storeu_ps(velBY, vBY);
+
+	// NOTE(final): Static bodies may be in multiple lanes, but they have no mass so their velocity stays the same
+	for (U32 lane = 0; lane < PHYSICS_SOLVER_LANE_COUNT; ++lane) {
+		velocities[batch->bodyIndicesA[lane]] = V2(velAX[lane], velAY[lane]);
+		velocities[batch->bodyIndicesB[lane]] = V2(velBX[lane], velBY[lane]);
+	}
+
+	__m128 absImpulse = _mm_andnot_ps(_mm_set1_ps(-0.0f), impulse);
+	__m128 velocityChange = _mm_mul_ps(absImpulse, _mm_add_ps(invMassA, invMassB));
+	velocityChange = _mm_max_ps(velocityChange, _mm_shuffle_ps(velocityChange, velocityChange, _MM_SHUFFLE(1, 0, 3, 2)));
+	velocityChange = _mm_max_ps(velocityChange, _mm_shuffle_ps(velocityChange, velocityChange, _MM_SHUFFLE(2, 3, 0, 1)));
+	F32 result = _mm_cvtss_f32(velocityChange);
+	return(result);
+}
+
+external void PhysicsSolverSolveColored(Physics *physics, PhysicsSolver *solver, F32 deltaTime) {
+	F32 invDeltaTime = 1.0f / deltaTime;
+	for (U32 iteration = 0; iteration < solver->maxIterationCount; iteration++) {
+		F32 maxVelocityChange = 0;
+		for (U32 batchIndex = 0; batchIndex < solver->batchCount; ++batchIndex) {
+			F32 velocityChange = PhysicsSolverBatchSolve(solver->batches + batchIndex, physics->bodyData.velocities, false, invDeltaTime);
+			maxVelocityChange = Max(maxVelocityChange, velocityChange);
+		}
+		for (U32 overflowIndex = 0; overflowIndex < solver->overflowCount; ++overflowIndex) {
+			F32 velocityChange = PhysicsSolverContactVelocity(physics->bodyData.velocities, physics->contacts + solver->overflowContacts[overflowIndex], invDeltaTime);
+			maxVelocityChange = Max(maxVelocityChange, velocityChange);
+		}
+		++physics->stats.solverVelocityIterationCount;
+		if (iteration + 1 >= solver->minIterationCount && maxVelocityChange < solver->velocityTolerance) {
+			break;
+		}
+	}
+	for (U32 iteration = 0; iteration < solver->maxIterationCount; iteration++) {
+		F32 maxVelocityChange = 0;
+		for (U32 batchIndex = 0; batchIndex < solver->batchCount; ++batchIndex) {
+			F32 velocityChange = PhysicsSolverBatchSolve(solver->batches + batchIndex, physics->bodyData.biasVelocities, true, invDeltaTime);
+			maxVelocityChange = Max(maxVelocityChange, velocityChange);
+		}
+		for (U32 overflowIndex = 0; overflowIndex < solver->overflowCount; ++overflowIndex) {
+			F32 velocityChange = PhysicsSolverContactPosition(physics->bodyData.biasVelocities, physics->contacts + solver->overflowContacts[overflowIndex], invDeltaTime);
+			maxVelocityChange = Max(maxVelocityChange, velocityChange);
+		}
+		++physics->stats.solverPositionIterationCount;
+		if (iteration + 1 >= solver->minIterationCount && maxVelocityChange < solver->velocityTolerance) {
+			break;
+		}
+	}
+
+	// NOTE(final): Store the accumulated impulses back, so the next step can be warm started
+	for (U32 batchIndex = 0; batchIndex < solver->batchCount; ++batchIndex) {
+		PhysicsSolverBatch *batch = solver->batches + batchIndex;
+		for (U32 lane = 0; lane < batch->laneCount; ++lane) {
+			Contact *contact = physics->contacts + batch->contactIndices[lane];
+			contact->normalImpulse = batch->normalImpulse[lane];
+			contact->bias = batch->biasImpulse[lane];
+		}
+	}
+}
\ No newline at end of file
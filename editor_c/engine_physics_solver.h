@@ -0,0 +1,67 @@
+#pragma once
+
+#include "engine_types.h"
+#include "engine_math.h"
+#include "engine_memory.h"
+
+struct Physics;
+struct Body;
+
+enum PhysicsSolverType {
+	PhysicsSolverType_Scalar = 0,
+	// NOTE(final): Contacts are graph colored, so contacts without a shared dynamic body are solved four at once with SSE
+	PhysicsSolverType_ColoredSIMD,
+
+	PhysicsSolverType_Count,
+};
+
+constant U32 PHYSICS_SOLVER_LANE_COUNT = 4;
+// NOTE(final): One bit per color in the body color masks, contacts which do not get a color are solved scalar
+constant U32 PHYSICS_SOLVER_MAX_COLOR_COUNT = 32;
+
+// NOTE(final): Contacts of one color in SoA layout, unused lanes use the static tile body and have no mass
+struct PhysicsSolverBatch {
+	U32 bodyIndicesA[PHYSICS_SOLVER_LANE_COUNT];
+	U32 bodyIndicesB[PHYSICS_SOLVER_LANE_COUNT];
+	U32 contactIndices[PHYSICS_SOLVER_LANE_COUNT];
+	F32 normalX[PHYSICS_SOLVER_LANE_COUNT];
+	F32 normalY[PHYSICS_SOLVER_LANE_COUNT];
+	F32 distance[PHYSICS_SOLVER_LANE_COUNT];
+	F32 invMassA[PHYSICS_SOLVER_LANE_COUNT];
+	F32 invMassB[PHYSICS_SOLVER_LANE_COUNT];
+	F32 massNormal[PHYSICS_SOLVER_LANE_COUNT];
+	F32 normalImpulse[PHYSICS_SOLVER_LANE_COUNT];
+	F32 biasImpulse[PHYSICS_SOLVER_LANE_COUNT];
+	U32 laneCount;
+};
+
+// NOTE(final): The batches and the per contact arrays are valid for the current step only
+struct PhysicsSolver {
+	PhysicsSolverType type;
+	U32 minIterationCount;
+	U32 maxIterationCount;
+	// NOTE(final): Max change of the relative normal velocity of any contact in the last iteration, below which the solver stops
+	F32 velocityTolerance;
+	PhysicsSolverBatch *batches;
+	U32 batchCount;
+	U32 *overflowContacts;
+	U32 overflowCount;
+	U32 colorCount;
+	U32 *contactColors;
+	U32 *colorStarts;
+	U32 *sortedContacts;
+	// NOTE(final): Colors used by each awake body, indexed by the dense island index
+	U32 *bodyColorMasks;
+};
+
+inline void PhysicsSolverIterationsSet(PhysicsSolver *solver, U32 minIterationCount, U32 maxIterationCount, F32 velocityTolerance) {
+	Assert(minIterationCount > 0 && minIterationCount <= maxIterationCount);
+	solver->minIterationCount = minIterationCount;
+	solver->maxIterationCount = maxIterationCount;
+	solver->velocityTolerance = velocityTolerance;
+}
+
+external void PhysicsSolverInit(PhysicsSolver *solver, MemoryBlock *memory, PhysicsSolverType type, U32 maxBodyCount);
+external void PhysicsSolverPrepare(Physics *physics);
+external void PhysicsSolverColor(Physics *physics, PhysicsSolver *solver, MemoryBlock *stepMemory);
+external void PhysicsSolverSolveColored(Physics *physics, PhysicsSolver *solver, F32 deltaTime);
\ No newline at end of file
@@ -0,0 +1,190 @@
+#include "engine_physics_tilemap.h"
+
+global_variable Vec2i globalPhysicsTileNeighbourOffsets[4] = {
+	V2i(0, -1),
+	V2i(-1, 0),
+	V2i(0, 1),
+	V2i(1, 0),
+};
+
+external void PhysicsTileMapInit(PhysicsTileMap *tileMap, MemoryBlock *memory, U32 dimension, const Vec2f &tileSize) {
+	Assert(dimension > 0);
+	tileMap->dimension = dimension;
+	tileMap->tileOffset = (S32)(dimension / 2) - 1;
+	tileMap->tileSize = tileSize;
+	tileMap->cells = PushArray(memory, U8, dimension * dimension);
+	tileMap->cellBoxes = PushArray(memory, U32, dimension * dimension);
+	// NOTE(final): Worst case is a checkerboard, where each solid tile is a box of its own
+	tileMap->boxCapacity = (dimension * dimension) / 2 + 2;
+	tileMap->boxes = PushArray(memory, PhysicsTileBox, tileMap->boxCapacity);
+	PhysicsTileMapClear(tileMap);
+}
+
+external void PhysicsTileMapClear(PhysicsTileMap *tileMap) {
+	if (tileMap->cells) {
+		ZeroArray(tileMap->cells, tileMap->dimension * tileMap->dimension);
+		ZeroArray(tileMap->cellBoxes, tileMap->dimension * tileMap->dimension);
+	}
+	tileMap->solidCount = 0;
+	tileMap->boxCount = 1;
+	tileMap->freeBox = PHYSICS_TILE_NULL_BOX;
+	tileMap->activeBoxCount = 0;
+}
+
+external AABB PhysicsTileMapBoxBounds(const PhysicsTileMap *tileMap, const PhysicsTileBox *box) {
+	AABB result;
+	result.min = Vec2Hadamard(V2((F32)box->minTile.x, (F32)box->minTile.y), tileMap->tileSize);
+	result.max = Vec2Hadamard(V2((F32)(box->maxTile.x + 1), (F32)(box->maxTile.y + 1)), tileMap->tileSize);
+	return(result);
+}
+
+inline U8 *PhysicsTileMapCellGet(PhysicsTileMap *tileMap, S32 tileX, S32 tileY) {
+	U8 *result = 0;
+	if (PhysicsTileMapContains(tileMap, tileX, tileY)) {
+		U32 cellIndex = (U32)(tileY + tileMap->tileOffset) * tileMap->dimension + (U32)(tileX + tileMap->tileOffset);
+		result = tileMap->cells + cellIndex;
+	}
+	return(result);
+}
+
+inline U32 *PhysicsTileMapCellBoxGet(PhysicsTileMap *tileMap, S32 tileX, S32 tileY) {
+	U32 *result = 0;
+	if (PhysicsTileMapContains(tileMap, tileX, tileY)) {
+		U32 cellIndex = (U32)(tileY + tileMap->tileOffset) * tileMap->dimension + (U32)(tileX + tileMap->tileOffset);
+		result = tileMap->cellBoxes + cellIndex;
+	}
+	return(result);
+}
+
+internal U32 PhysicsTileMapBoxAllocate(PhysicsTileMap *tileMap) {
+	U32 result;
+	if (tileMap->freeBox != PHYSICS_TILE_NULL_BOX) {
+		result = tileMap->freeBox;
+		tileMap->freeBox = tileMap->boxes[result].nextFree;
+	} else {
+		Assert(tileMap->boxCount < tileMap->boxCapacity);
+		result = tileMap->boxCount++;
+	}
+	++tileMap->activeBoxCount;
+	return(result);
+}
+
+internal void PhysicsTileMapBoxRelease(PhysicsTileMap *tileMap, U32 boxIndex, Vec2i *regionMin, Vec2i *regionMax) {
+	PhysicsTileBox *box = tileMap->boxes + boxIndex;
+	Assert(box->tileCount > 0);
+	for (S32 y = box->minTile.y; y <= box->maxTile.y; ++y) {
+		for (S32 x = box->minTile.x; x <= box->maxTile.x; ++x) {
+			U32 *cellBox = PhysicsTileMapCellBoxGet(tileMap, x, y);
+			Assert(cellBox && *cellBox == boxIndex);
+			*cellBox = PHYSICS_TILE_NULL_BOX;
+		}
+	}
+	*regionMin = V2i(Min(regionMin->x, box->minTile.x), Min(regionMin->y, box->minTile.y));
+	*regionMax = V2i(Max(regionMax->x, box->maxTile.x), Max(regionMax->y, box->maxTile.y));
+	box->tileCount = 0;
+	box->nextFree = tileMap->freeBox;
+	tileMap->freeBox = boxIndex;
+	Assert(tileMap->activeBoxCount > 0);
+	--tileMap->activeBoxCount;
+}
+
+inline B32 PhysicsTileMapIsMergeable(PhysicsTileMap *tileMap, S32 tileX, S32 tileY) {
+	U32 *cellBox = PhysicsTileMapCellBoxGet(tileMap, tileX, tileY);
+	B32 result = cellBox && (*cellBox == PHYSICS_TILE_NULL_BOX) && (PhysicsTileMapGet(tileMap, tileX, tileY) & PHYSICS_TILE_SOLID);
+	return(result);
+}
+
+// NOTE(final): Greedy meshing of all unassigned solid tiles in the given region.
+//				Runs are extended along x first and then grown along y, as long as the full run is solid.
+//				Solid tiles outside the region are always assigned already, so boxes never need to be clipped to the region.
+internal void PhysicsTileMapMerge(PhysicsTileMap *tileMap, const Vec2i &regionMin, const Vec2i &regionMax) {
+	for (S32 y = regionMin.y; y <= regionMax.y; ++y) {
+		for (S32 x = regionMin.x; x <= regionMax.x; ++x) {
+			if (!PhysicsTileMapIsMergeable(tileMap, x, y)) {
+				continue;
+			}
+
+			S32 maxX = x;
+			while (PhysicsTileMapIsMergeable(tileMap, maxX + 1, y)) {
+				++maxX;
+			}
+
+			S32 maxY = y;
+			for (;;) {
+				B32 canGrow = true;
+				for (S32 growX = x; growX <= maxX; ++growX) {
+					if (!PhysicsTileMapIsMergeable(tileMap, growX, maxY + 1)) {
+						canGrow = false;
+						break;
+					}
+				}
+				if (!canGrow) {
+					break;
+				}
+				++maxY;
+			}
+
+			U32 boxIndex = PhysicsTileMapBoxAllocate(tileMap);
+			PhysicsTileBox *box = tileMap->boxes + boxIndex;
+			box->minTile = V2i(x, y);
+			box->maxTile = V2i(maxX, maxY);
+			box->tileCount = (U32)((maxX - x + 1) * (maxY - y + 1));
+			box->nextFree = PHYSICS_TILE_NULL_BOX;
+			for (S32 boxY = y; boxY <= maxY; ++boxY) {
+				for (S32 boxX = x; boxX <= maxX; ++boxX) {
+					*PhysicsTileMapCellBoxGet(tileMap, boxX, boxY) = boxIndex;
+				}
+			}
+		}
+	}
+}
+
+external void PhysicsTileMapSet(PhysicsTileMap *tileMap, S32 tileX, S32 tileY, B32 solid) {
+	U8 *cell = PhysicsTileMapCellGet(tileMap, tileX, tileY);
+	Assert(cell);
+	if (!cell || ((*cell & PHYSICS_TILE_SOLID) != 0) == (solid != 0)) {
+		return;
+	}
+
+	// NOTE(final): Update the solid flag and the neighbour flags in both directions
+	U8 neighbourFlags = 0;
+	for (U32 faceIndex = 0; faceIndex < ArrayCount(globalPhysicsTileNeighbourOffsets); ++faceIndex) {
+		Vec2i offset = globalPhysicsTileNeighbourOffsets[faceIndex];
+		U8 *neighbour = PhysicsTileMapCellGet(tileMap, tileX + offset.x, tileY + offset.y);
+		if (!neighbour) {
+			continue;
+		}
+		// NOTE(final): Opposite face is always two faces away
+		U8 oppositeFlag = (U8)(1 << (PHYSICS_TILE_NEIGHBOUR_SHIFT + ((faceIndex + 2) % 4)));
+		if (solid) {
+			*neighbour |= oppositeFlag;
+		} else {
+			*neighbour &= ~oppositeFlag;
+		}
+		if (*neighbour & PHYSICS_TILE_SOLID) {
+			neighbourFlags |= (U8)(1 << (PHYSICS_TILE_NEIGHBOUR_SHIFT + faceIndex));
+		}
+	}
+
+	if (solid) {
+		*cell = PHYSICS_TILE_SOLID | neighbourFlags;
+		++tileMap->solidCount;
+	} else {
+		*cell = neighbourFlags;
+		Assert(tileMap->solidCount > 0);
+		--tileMap->solidCount;
+	}
+
+	// NOTE(final): Release the boxes of the changed tile and its direct neighbours and merge the covered region again.
+	//				This keeps edits local, the rest of the map keeps its boxes.
+	Vec2i regionMin = V2i(tileX, tileY);
+	Vec2i regionMax = V2i(tileX, tileY);
+	for (U32 neighbourIndex = 0; neighbourIndex < ArrayCount(globalPhysicsTileNeighbourOffsets) + 1; ++neighbourIndex) {
+		Vec2i offset = neighbourIndex < ArrayCount(globalPhysicsTileNeighbourOffsets) ? globalPhysicsTileNeighbourOffsets[neighbourIndex] : V2i(0, 0);
+		U32 boxIndex = PhysicsTileMapBoxGet(tileMap, tileX + offset.x, tileY + offset.y);
+		if (boxIndex != PHYSICS_TILE_NULL_BOX) {
+			PhysicsTileMapBoxRelease(tileMap, boxIndex, &regionMin, &regionMax);
+		}
+	}
+	PhysicsTileMapMerge(tileMap, regionMin, regionMax);
+}
@@ -0,0 +1,123 @@
+#pragma once
+
+#include "engine_types.h"
+#include "engine_math.h"
+#include "engine_memory.h"
+
+constant U8 PHYSICS_TILE_SOLID = 1 << 0;
+// NOTE(final): Neighbour flags are in the same order as the box edge normals (Bottom, Left, Top, Right)
+constant U8 PHYSICS_TILE_NEIGHBOUR_SHIFT = 1;
+constant U8 PHYSICS_TILE_NEIGHBOUR_BOTTOM = 1 << 1;
+constant U8 PHYSICS_TILE_NEIGHBOUR_LEFT = 1 << 2;
+constant U8 PHYSICS_TILE_NEIGHBOUR_TOP = 1 << 3;
+constant U8 PHYSICS_TILE_NEIGHBOUR_RIGHT = 1 << 4;
+
+constant U32 PHYSICS_TILE_NULL_BOX = 0;
+
+// NOTE(final): Axis aligned rectangle of solid tiles, tile range is inclusive
+struct PhysicsTileBox {
+	Vec2i minTile;
+	Vec2i maxTile;
+	// NOTE(final): Zero when the box is in the free list
+	U32 tileCount;
+	U32 nextFree;
+};
+
+// NOTE(final): Implicit static collider for a grid of tiles, there is no body per tile.
+//				Solid tiles are greedy merged into as few boxes as possible, every solid tile belongs to exactly one box.
+//				Tile (0, 0) has its min corner at the world origin.
+struct PhysicsTileMap {
+	U8 *cells;
+	U32 *cellBoxes;
+	U32 dimension;
+	S32 tileOffset;
+	Vec2f tileSize;
+	U32 solidCount;
+
+	// NOTE(final): Box zero is never used
+	PhysicsTileBox *boxes;
+	U32 boxCapacity;
+	U32 boxCount;
+	U32 freeBox;
+	U32 activeBoxCount;
+};
+
+inline B32 PhysicsTileMapContains(const PhysicsTileMap *tileMap, S32 tileX, S32 tileY) {
+	S32 x = tileX + tileMap->tileOffset;
+	S32 y = tileY + tileMap->tileOffset;
+	B32 result = tileMap->cells && (x >= 0 && x < (S32)tileMap->dimension) && (y >= 0 && y < (S32)tileMap->dimension);
+	return(result);
+}
+
+inline U8 PhysicsTileMapGet(const PhysicsTileMap *tileMap, S32 tileX, S32 tileY) {
+	U8 result = 0;
+	if (PhysicsTileMapContains(tileMap, tileX, tileY)) {
+		U32 cellIndex = (U32)(tileY + tileMap->tileOffset) * tileMap->dimension + (U32)(tileX + tileMap->tileOffset);
+		result = tileMap->cells[cellIndex];
+	}
+	return(result);
+}
+
+inline U32 PhysicsTileMapBoxGet(const PhysicsTileMap *tileMap, S32 tileX, S32 tileY) {
+	U32 result = PHYSICS_TILE_NULL_BOX;
+	if (PhysicsTileMapContains(tileMap, tileX, tileY)) {
+		U32 cellIndex = (U32)(tileY + tileMap->tileOffset) * tileMap->dimension + (U32)(tileX + tileMap->tileOffset);
+		result = tileMap->cellBoxes[cellIndex];
+	}
+	return(result);
+}
+
+inline Vec2f PhysicsTileMapTileCenter(const PhysicsTileMap *tileMap, S32 tileX, S32 tileY) {
+	Vec2f result = Vec2Hadamard(V2((F32)tileX, (F32)tileY), tileMap->tileSize) + tileMap->tileSize * 0.5f;
+	return(result);
+}
+
+// NOTE(final): Walks the tile boxes overlapping the tiles of the bounds, every box is returned once.
+//				A box is returned at its first tile inside the tile range only, so the visited boxes do not need to be remembered.
+struct PhysicsTileBoxIterator {
+	const PhysicsTileMap *tileMap;
+	S32 minTileX;
+	S32 minTileY;
+	S32 maxTileX;
+	S32 maxTileY;
+	S32 tileX;
+	S32 tileY;
+};
+
+inline PhysicsTileBoxIterator PhysicsTileBoxIteratorBegin(const PhysicsTileMap *tileMap, const AABB &bounds) {
+	PhysicsTileBoxIterator result = {};
+	result.tileMap = tileMap;
+	result.minTileX = FloorF32ToS32(bounds.min.x / tileMap->tileSize.x);
+	result.minTileY = FloorF32ToS32(bounds.min.y / tileMap->tileSize.y);
+	result.maxTileX = FloorF32ToS32(bounds.max.x / tileMap->tileSize.x);
+	result.maxTileY = FloorF32ToS32(bounds.max.y / tileMap->tileSize.y);
+	result.tileX = result.minTileX;
+	result.tileY = result.minTileY;
+	return(result);
+}
+
+// NOTE(final): Returns the null box when all tiles are walked
+inline U32 PhysicsTileBoxIteratorNext(PhysicsTileBoxIterator *iterator) {
+	const PhysicsTileMap *tileMap = iterator->tileMap;
+	while (iterator->tileY <= iterator->maxTileY) {
+		S32 tileX = iterator->tileX;
+		S32 tileY = iterator->tileY;
+		if (++iterator->tileX > iterator->maxTileX) {
+			iterator->tileX = iterator->minTileX;
+			++iterator->tileY;
+		}
+		U32 boxIndex = PhysicsTileMapBoxGet(tileMap, tileX, tileY);
+		if (boxIndex != PHYSICS_TILE_NULL_BOX) {
+			const PhysicsTileBox *box = tileMap->boxes + boxIndex;
+			if (tileX == Max(box->minTile.x, iterator->minTileX) && tileY == Max(box->minTile.y, iterator->minTileY)) {
+				return(boxIndex);
+			}
+		}
+	}
+	return(PHYSICS_TILE_NULL_BOX);
+}
+
+external void PhysicsTileMapInit(PhysicsTileMap *tileMap, MemoryBlock *memory, U32 dimension, const Vec2f &tileSize);
+external void PhysicsTileMapClear(PhysicsTileMap *tileMap);
+external void PhysicsTileMapSet(PhysicsTileMap *tileMap, S32 tileX, S32 tileY, B32 solid);
+external AABB PhysicsTileMapBoxBounds(const PhysicsTileMap *tileMap, const PhysicsTileBox *box);
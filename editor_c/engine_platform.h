@@ -3,6 +3,7 @@
 #include "engine_memory.h"
 #include "engine_render.h"
 #include "engine_input.h"
+#include "engine_jobs.h"
 
 struct AppState {
 	void *renderStorageBase;
@@ -13,4 +14,6 @@ struct AppState {
 
 	void *transientStorageBase;
 	memory_size transientStorageSize;
+
+	PlatformJobs jobs;
 };
\ No newline at end of file
@@ -1,6 +1,7 @@
 #pragma once
 
 #include <stdint.h>
+#include <stddef.h>
 
 #define internal static
 #define global_variable static
@@ -41,7 +42,7 @@ typedef size_t memory_size;
 	StaticAssert_(sizeof(type) == 4, __LINE__)
 #else
 #define Assert(exp)
-#define StaticAssert(exp, name)
+#define StaticAssert(exp)
 #define StaticAlignmentAssert(type)
 #define StaticEnumAssert(type)
 #endif
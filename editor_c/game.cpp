@@ -2,7 +2,7 @@
 
 #include "game_internal.h"
 
-internal void GameInit(GameState *gameState) {
+internal void GameInit(GameState *gameState, AppState *appState) {
 	// NOTE(final): Define number of tiles to fit on screen with 100% scale
 	gameState->tileSize = V2(1.0f, 1.0f);
 	gameState->areaTileCount = V2i(16, 10);
@@ -25,14 +25,19 @@ internal void GameInit(GameState *gameState) {
 	gameState->editor.usedTiles.Init();
 
 	// NOTE(final): Init physics system
-	memory_size physicsMemorySize = MegaBytes(32);
+	memory_size physicsMemorySize = MegaBytes(64);
 	gameState->physics.physicsMemory = MemoryBlockCreateFrom(&gameState->persistentMemory, physicsMemorySize);
-	PhysicsInit(&gameState->physics, V2(0, -0.25f));
+	gameState->physics.jobs = &appState->jobs;
+	PhysicsInit(&gameState->physics, V2(0, -15.0f), gameState->tileSize);
+	PhysicsStepRateSet(&gameState->physics, GAME_PHYSICS_STEP_RATE, GAME_PHYSICS_MAX_STEP_COUNT);
+	PhysicsTileMapInit(&gameState->physics.tileMap, &gameState->physics.physicsMemory, EDITOR_MAX_TILE_DIMENSION, gameState->tileSize);
 
 	// NOTE(final): Add a player dynamic body
 	Vec2f playerExt = V2(0.4f, 0.9f);
 	Vec2f playerPos = V2(0, 0);
 	gameState->playerBody = PhysicsBodyCreate(&gameState->physics, BodyType::BodyType_Dynamic, playerExt, playerPos, 1.0f);
+	// NOTE(final): The player jumps fast enough to pass through a tile in one step
+	PhysicsBodySetBullet(&gameState->physics, PhysicsBodyGet(&gameState->physics, gameState->playerBody), true);
 }
 
 internal Vec2f GameEditorMousePosGet(EditorState *editor, InputState *inputState) {
@@ -53,7 +58,7 @@ inline Tile *GameEditorTileGet(GameState *game, S32 tileX, S32 tileY) {
 	Tile *tile = 0;
 	U32 tileIndex = GameEditorTileIndexGet(tileX, tileY);
 	if (editor->tilesMap[tileIndex]) {
-		tile = editor->tilesPool.PopBack();
+		tile = editor->tilesMap[tileIndex];
 	}
 	return(tile);
 }
@@ -71,9 +76,8 @@ internal void GameEditorTileAdd(GameState *game, S32 tileX, S32 tileY) {
 		editor->usedTiles.PushBack(tile);
 		editor->tilesMap[tileIndex] = tile;
 
-		// NOTE(final): Add static body for that tile
-		Vec2f tileWorldPos = Vec2Hadamard(V2((F32)tileX, (F32)tileY), game->tileSize) + game->tileSize * 0.5f;
-		tile->body = PhysicsBodyCreate(&game->physics, BodyType::BodyType_Static, game->tileSize * 0.5f, tileWorldPos, 0.0f);
+		// NOTE(final): Tiles are collided by the implicit tile map, not by static bodies
+		PhysicsTileSet(&game->physics, tileX, tileY, true);
 	}
 
 }
@@ -87,8 +91,7 @@ internal void GameEditorTileRemove(GameState *gameState, S32 tileX, S32 tileY) {
 	if (editor->tilesMap[tileIndex]) {
 		Tile *tile = editor->tilesMap[tileIndex];
 
-		Assert(tile->body);
-		PhysicsBodyRemove(&gameState->physics, tile->body);
+		PhysicsTileSet(&gameState->physics, tileX, tileY, false);
 
 		editor->tilesMap[tileIndex] = 0;
 		editor->usedTiles.Remove(tile);
@@ -97,23 +100,78 @@ internal void GameEditorTileRemove(GameState *gameState, S32 tileX, S32 tileY) {
 	}
 }
 
+internal void GameTilesRender(GameState *gameState, RenderState *renderState, const Transform &cameraTransform) {
+	EditorState *editor = &gameState->editor;
+	Vec2f tileSize = gameState->tileSize;
+	Vec2f tileBounds[4] = {
+		V2(tileSize.x, tileSize.y) * 0.5f,
+		V2(-tileSize.x, tileSize.y) * 0.5f,
+		V2(-tileSize.x, -tileSize.y) * 0.5f,
+		V2(tileSize.x, -tileSize.y) * 0.5f,
+	};
+	for (Tile *tile = (Tile *)editor->usedTiles.next; tile != (Tile *)&editor->usedTiles; tile = (Tile *)tile->next) {
+		Vec2f tilePos = Vec2Hadamard(V2((F32)tile->tilePos.x, (F32)tile->tilePos.y), tileSize) + tileSize * 0.5f;
+		Transform tileTransform = TransformMult(TransformMakeTranslation(tilePos), cameraTransform);
+		RenderPushPolygon(renderState, tileTransform, 4, tileBounds);
+	}
+}
+
 internal void GamePhysicsRender(Physics *physics, RenderState *renderState, const Transform &cameraTransform) {
 	Vec2f verts[4];
+	PhysicsBodyData *bodyData = &physics->bodyData;
 	for (U32 bodyIndex = 0; bodyIndex < physics->bodyCount; ++bodyIndex) {
-		Body *body = physics->bodies[bodyIndex];
-		Transform bodyTransform = TransformMult(TransformMakeTranslation(body->position), cameraTransform);
-
-		verts[0] = V2(body->radius.x, body->radius.y);
-		verts[1] = V2(-body->radius.x, body->radius.y);
-		verts[2] = V2(-body->radius.x, -body->radius.y);
-		verts[3] = V2(body->radius.x, -body->radius.y);
-
-		Vec4f color = body->type == BodyType::BodyType_Static ? V4(1, 1, 1, 1) : V4(0, 0, 1, 1);
+		Vec2f radius = bodyData->radii[bodyIndex];
+		U32 flags = bodyData->flags[bodyIndex];
+		Vec2f prevPos = bodyData->prevPositions[bodyIndex];
+		Vec2f pos = prevPos + (bodyData->positions[bodyIndex] - prevPos) * physics->interpolationAlpha;
+		Transform bodyTransform = TransformMult(TransformMakeTranslation(pos), cameraTransform);
+
+		verts[0] = V2(radius.x, radius.y);
+		verts[1] = V2(-radius.x, radius.y);
+		verts[2] = V2(-radius.x, -radius.y);
+		verts[3] = V2(radius.x, -radius.y);
+
+		Vec4f color = !(flags & PHYSICS_BODY_FLAG_DYNAMIC) ? V4(1, 1, 1, 1) : ((flags & PHYSICS_BODY_FLAG_AWAKE) ? V4(0, 0, 1, 1) : V4(0, 0, 0.5f, 1));
 		RenderPushPolygon(renderState, bodyTransform, 4, verts, color);
 	}
+
+	// NOTE(final): Outline of the merged tile boxes
+	PhysicsTileMap *tileMap = &physics->tileMap;
+	for (U32 boxIndex = 1; boxIndex < tileMap->boxCount; ++boxIndex) {
+		PhysicsTileBox *box = tileMap->boxes + boxIndex;
+		if (box->tileCount == 0) {
+			continue;
+		}
+		AABB bounds = PhysicsTileMapBoxBounds(tileMap, box);
+		verts[0] = V2(bounds.max.x, bounds.max.y);
+		verts[1] = V2(bounds.min.x, bounds.max.y);
+		verts[2] = V2(bounds.min.x, bounds.min.y);
+		verts[3] = V2(bounds.max.x, bounds.min.y);
+		RenderPushLines(renderState, cameraTransform, 4, verts, true, V4(0, 1, 0, 1), 2.0f);
+	}
 }
 
 
+#ifdef _DEBUG
+internal void GameContactGeneratorBenchmarkRun(GameState *gameState, MemoryBlock *tempMemory) {
+	const ShapeKind kinds[GAME_CONTACT_GENERATOR_BENCHMARK_COUNT][2] = {
+		{ ShapeKind::ShapeKind_Polygon3, ShapeKind::ShapeKind_Polygon3 },
+		{ ShapeKind::ShapeKind_Box, ShapeKind::ShapeKind_Polygon4 },
+		{ ShapeKind::ShapeKind_Polygon5, ShapeKind::ShapeKind_Polygon6 },
+		{ ShapeKind::ShapeKind_Polygon8, ShapeKind::ShapeKind_Polygon8 },
+		{ ShapeKind::ShapeKind_Box, ShapeKind::ShapeKind_Circle },
+		{ ShapeKind::ShapeKind_Polygon6, ShapeKind::ShapeKind_Circle },
+	};
+	for (U32 benchmarkIndex = 0; benchmarkIndex < GAME_CONTACT_GENERATOR_BENCHMARK_COUNT; ++benchmarkIndex) {
+		GameContactGeneratorBenchmark *benchmark = gameState->contactGeneratorBenchmarks + benchmarkIndex;
+		benchmark->kindA = kinds[benchmarkIndex][0];
+		benchmark->kindB = kinds[benchmarkIndex][1];
+		benchmark->result = ContactGeneratorBenchmark(tempMemory, benchmark->kindA, benchmark->kindB, GAME_CONTACT_GENERATOR_BENCHMARK_PAIR_COUNT, GAME_CONTACT_GENERATOR_BENCHMARK_REPEAT_COUNT, 1);
+		Assert(benchmark->result.mismatchCount == 0);
+	}
+}
+#endif
+
 external void GameUpdateAndRender(AppState *appState, RenderState *renderState, InputState *inputState) {
 	GameState *gameState = (GameState *)appState->persistentStorageBase;
 	TransientState *tranState = (TransientState *)appState->transientStorageBase;
@@ -129,7 +187,7 @@ external void GameUpdateAndRender(AppState *appState, RenderState *renderState,
 		// NOTE(final): Initialize editor state
 		*gameState = {};
 		gameState->persistentMemory = MemoryBlockCreate((U8 *)appState->persistentStorageBase + sizeof(GameState), appState->persistentStorageSize - sizeof(GameState), MemoryFlag::MemoryFlag_None);
-		GameInit(gameState);
+		GameInit(gameState, appState);
 		gameState->isInitialized = true;
 
 		// NOTE(final): Set area dimension and aspect ratio - This will never change
@@ -158,6 +216,12 @@ external void GameUpdateAndRender(AppState *appState, RenderState *renderState,
 		gameState->editorActive = !gameState->editorActive;
 	}
 
+#ifdef _DEBUG
+	if (InputButtonWasDown(inputState->keyboard.functionkeys[7])) {
+		GameContactGeneratorBenchmarkRun(gameState, &tranState->transientMemory);
+	}
+#endif
+
 	EditorState *editor = &gameState->editor;
 
 	editor->camera.transform = TransformMake(editor->camera.offset, 0.0f, editor->camera.scale);
@@ -283,11 +347,7 @@ external void GameUpdateAndRender(AppState *appState, RenderState *renderState,
 		U32 lineCountY = halfLineCountY * 2;
 
 		// NOTE(final): Draw used tiles
-		for (Tile *tile = (Tile *)editor->usedTiles.next; tile != (Tile *)&editor->usedTiles; tile = (Tile *)tile->next) {
-			Vec2f tilePos = Vec2Hadamard(V2((F32)tile->tilePos.x, (F32)tile->tilePos.y), tileSize) + tileSize * 0.5f;
-			Transform tileTransform = TransformMult(TransformMakeTranslation(tilePos), editor->camera.transform);
-			RenderPushPolygon(renderState, tileTransform, 4, tileBounds);
-		}
+		GameTilesRender(gameState, renderState, editor->camera.transform);
 
 		TemporaryMemory tempMemory = TemporaryMemoryBegin(&tranState->transientMemory);
 		Vec2f *gridLinePoints = PushArray(&tranState->transientMemory, Vec2f, Max(lineCountX, lineCountY) * 2);
@@ -326,22 +386,36 @@ external void GameUpdateAndRender(AppState *appState, RenderState *renderState,
 
 		GamePhysicsRender(&gameState->physics, renderState, editor->camera.transform);
 	} else {
-		F32 moveSpeedX = 0.1f;
-		F32 moveSpeedY = 0.5f;
-		if (InputButtonIsDown(inputState->keyboard.moveRight)) {
-			gameState->playerBody->velocity += V2(1, 0) * moveSpeedX;
-		} else if (InputButtonIsDown(inputState->keyboard.moveLeft)) {
-			gameState->playerBody->velocity += V2(-1, 0) * moveSpeedX;
-		}
-		if (InputButtonIsDown(inputState->keyboard.moveUp)) {
-			gameState->playerBody->velocity += V2(0, 1) * moveSpeedY;
-		} else if (InputButtonIsDown(inputState->keyboard.moveDown)) {
-			gameState->playerBody->velocity += V2(0, -1) * moveSpeedY;
+		// NOTE(final): Movement accelerations in units per second squared, scaled by the step delta time like the gravity
+		F32 moveAccelerationX = 6.0f;
+		F32 moveAccelerationY = 30.0f;
+		Physics *physics = &gameState->physics;
+		Body *playerBody = PhysicsBodyGet(physics, gameState->playerBody);
+		Assert(playerBody);
+
+		// NOTE(final): The player velocity is changed before every step, so the movement does not depend on the frame rate
+		U32 stepCount = PhysicsFrameBegin(physics, inputState->deltaTime);
+		F32 moveSpeedX = moveAccelerationX * physics->stepDeltaTime;
+		F32 moveSpeedY = moveAccelerationY * physics->stepDeltaTime;
+		for (U32 stepIndex = 0; stepIndex < stepCount; ++stepIndex) {
+			Vec2f playerVelocity = PhysicsBodyGetVelocity(physics, playerBody);
+			if (InputButtonIsDown(inputState->keyboard.moveRight)) {
+				playerVelocity += V2(1, 0) * moveSpeedX;
+			} else if (InputButtonIsDown(inputState->keyboard.moveLeft)) {
+				playerVelocity += V2(-1, 0) * moveSpeedX;
+			}
+			if (InputButtonIsDown(inputState->keyboard.moveUp)) {
+				playerVelocity += V2(0, 1) * moveSpeedY;
+			} else if (InputButtonIsDown(inputState->keyboard.moveDown)) {
+				playerVelocity += V2(0, -1) * moveSpeedY;
+			}
+			PhysicsBodySetVelocity(physics, playerBody, playerVelocity);
+			PhysicsStep(physics);
 		}
 
-		gameState->camera.offset = -gameState->playerBody->position;
+		gameState->camera.offset = -PhysicsBodyGetInterpolatedPosition(physics, playerBody);
 
-		PhysicsUpdate(&gameState->physics, inputState);
+		GameTilesRender(gameState, renderState, gameState->camera.transform);
 		GamePhysicsRender(&gameState->physics, renderState, gameState->camera.transform);
 	}
 }
\ No newline at end of file
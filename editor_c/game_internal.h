@@ -13,7 +13,6 @@ struct TransientState {
 
 struct Tile : LinkedListItem {
 	Vec2i tilePos;
-	Body *body;
 };
 StaticAlignmentAssert(Tile);
 
@@ -23,9 +22,26 @@ enum EditorDrawType {
 	EditorDrawType_Remove,
 };
 
-constant U32 EDITOR_MAX_TILE_POOL_CAPACITY = 2048;
 constant U32 EDITOR_MAX_TILE_DIMENSION = 256;
 constant U32 EDITOR_MAX_TILE_MAP_COUNT = EDITOR_MAX_TILE_DIMENSION * EDITOR_MAX_TILE_DIMENSION;
+// NOTE(final): Tiles have no physics bodies, so the whole map can be painted
+constant U32 EDITOR_MAX_TILE_POOL_CAPACITY = EDITOR_MAX_TILE_MAP_COUNT;
+
+// NOTE(final): Physics runs at a fixed rate independent of the monitor refresh, the rendering interpolates between the steps
+constant F32 GAME_PHYSICS_STEP_RATE = 60.0f;
+constant U32 GAME_PHYSICS_MAX_STEP_COUNT = 4;
+
+#ifdef _DEBUG
+// NOTE(final): Contact generator timings of the last benchmark run, F8 runs it again. Look at them in the debugger.
+struct GameContactGeneratorBenchmark {
+	ShapeKind kindA;
+	ShapeKind kindB;
+	ContactGeneratorBenchmarkResult result;
+};
+constant U32 GAME_CONTACT_GENERATOR_BENCHMARK_COUNT = 6;
+constant U32 GAME_CONTACT_GENERATOR_BENCHMARK_PAIR_COUNT = 4000;
+constant U32 GAME_CONTACT_GENERATOR_BENCHMARK_REPEAT_COUNT = 7;
+#endif
 
 struct Camera {
 	Vec2f offset;
@@ -66,5 +82,9 @@ struct GameState {
 
 	Physics physics;
 
-	Body *playerBody;
+	BodyHandle playerBody;
+
+#ifdef _DEBUG
+	GameContactGeneratorBenchmark contactGeneratorBenchmarks[GAME_CONTACT_GENERATOR_BENCHMARK_COUNT];
+#endif
 };
\ No newline at end of file
@@ -0,0 +1,51 @@
+// NOTE(final): Platform functions of the job system for pthreads. There is no posix platform layer yet, so this is not part of any build.
+// NOTE(final): The system headers come first, because the time header has a member which is called like the constant macro
+#include <pthread.h>
+#include <semaphore.h>
+
+#include "engine_jobs.h"
+
+struct PosixJobThread {
+	JobSystem *jobSystem;
+	U32 workerIndex;
+};
+
+global_variable PosixJobThread globalJobThreads[JOB_MAX_WORKER_COUNT];
+global_variable sem_t globalJobSemaphore;
+
+internal void *PosixJobThreadProc(void *param) {
+	PosixJobThread *thread = (PosixJobThread *)param;
+	JobSystemWorkerRun(thread->jobSystem, thread->workerIndex);
+	return 0;
+}
+
+external void PlatformJobThreadsCreate(JobSystem *jobSystem, U32 threadCount) {
+	sem_init(&globalJobSemaphore, 0, 0);
+	jobSystem->semaphore = &globalJobSemaphore;
+	for (U32 threadIndex = 0; threadIndex < threadCount; ++threadIndex) {
+		PosixJobThread *thread = globalJobThreads + threadIndex;
+		thread->jobSystem = jobSystem;
+		thread->workerIndex = threadIndex + 1;
+		pthread_t threadHandle;
+		pthread_create(&threadHandle, 0, PosixJobThreadProc, thread);
+		pthread_detach(threadHandle);
+	}
+}
+
+external void PlatformJobThreadSleep(JobSystem *jobSystem) {
+	sem_t *semaphore = (sem_t *)jobSystem->semaphore;
+	while (sem_wait(semaphore) != 0) {
+		// NOTE(final): Interrupted by a signal, wait again
+	}
+}
+
+external void PlatformJobThreadsWake(JobSystem *jobSystem, U32 count) {
+	// NOTE(final): A posix semaphore has no maximum count, so it is limited to the number of job threads like on win32
+	sem_t *semaphore = (sem_t *)jobSystem->semaphore;
+	int value = 0;
+	sem_getvalue(semaphore, &value);
+	U32 threadCount = jobSystem->workerCount - 1;
+	for (U32 wakeIndex = 0; wakeIndex < count && (U32)value + wakeIndex < threadCount; ++wakeIndex) {
+		sem_post(semaphore);
+	}
+}
\ No newline at end of file
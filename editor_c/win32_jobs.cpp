@@ -0,0 +1,36 @@
+#include "engine_jobs.h"
+
+#include <Windows.h>
+
+struct Win32JobThread {
+	JobSystem *jobSystem;
+	U32 workerIndex;
+};
+
+global_variable Win32JobThread globalJobThreads[JOB_MAX_WORKER_COUNT];
+
+internal DWORD WINAPI Win32JobThreadProc(LPVOID param) {
+	Win32JobThread *thread = (Win32JobThread *)param;
+	JobSystemWorkerRun(thread->jobSystem, thread->workerIndex);
+	return 0;
+}
+
+external void PlatformJobThreadsCreate(JobSystem *jobSystem, U32 threadCount) {
+	// NOTE(final): Every added job wakes a thread, the semaphore count is limited so a burst of jobs does not keep waking idle threads afterwards
+	jobSystem->semaphore = CreateSemaphoreEx(0, 0, threadCount > 0 ? threadCount : 1, 0, 0, SEMAPHORE_ALL_ACCESS);
+	for (U32 threadIndex = 0; threadIndex < threadCount; ++threadIndex) {
+		Win32JobThread *thread = globalJobThreads + threadIndex;
+		thread->jobSystem = jobSystem;
+		thread->workerIndex = threadIndex + 1;
+		HANDLE threadHandle = CreateThread(0, 0, Win32JobThreadProc, thread, 0, 0);
+		CloseHandle(threadHandle);
+	}
+}
+
+external void PlatformJobThreadSleep(JobSystem *jobSystem) {
+	WaitForSingleObjectEx(jobSystem->semaphore, INFINITE, FALSE);
+}
+
+external void PlatformJobThreadsWake(JobSystem *jobSystem, U32 count) {
+	ReleaseSemaphore(jobSystem->semaphore, count, 0);
+}
\ No newline at end of file
@@ -18,6 +18,8 @@ typedef PFNWGLSWAPINTERVALPROC(wgl_swap_interval);
 global_variable B32 globalRunning;
 global_variable S64 globalPerfCounterFrequency;
 global_variable wgl_swap_interval *wglSwapIntervalEXT;
+// NOTE(final): Too large for the stack, the deques of all workers are stored inline
+global_variable JobSystem globalJobSystem;
 
 DebugTable *globalDebugTable = 0;
 DebugMemory *globalDebugMemory = 0;
@@ -280,6 +282,18 @@ int WINAPI WinMain(HINSTANCE hInstance, HINSTANCE hPrevInstance, LPSTR pCmdLine,
 	appState.persistentStorageSize = MegaBytes(500LL);
 	appState.transientStorageSize = MegaBytes(32LL);
 
+	// NOTE(final): One job thread per logical processor, except for the main thread which works on the jobs as well
+	SYSTEM_INFO systemInfo;
+	GetSystemInfo(&systemInfo);
+	U32 jobThreadCount = systemInfo.dwNumberOfProcessors > 1 ? systemInfo.dwNumberOfProcessors - 1 : 0;
+	if (jobThreadCount > JOB_MAX_WORKER_COUNT - 1) {
+		jobThreadCount = JOB_MAX_WORKER_COUNT - 1;
+	}
+	JobSystemInit(&globalJobSystem, jobThreadCount);
+	appState.jobs.jobSystem = &globalJobSystem;
+	appState.jobs.PlatformAddJob = JobSystemAddJob;
+	appState.jobs.PlatformWaitForJobs = JobSystemWaitForJobs;
+
 #ifdef _DEBUG
 	LPVOID baseAddress = (LPVOID)TeraBytes(2ULL);
 #else
@@ -311,7 +325,8 @@ int WINAPI WinMain(HINSTANCE hInstance, HINSTANCE hPrevInstance, LPSTR pCmdLine,
 	InputState *newInput = &input[0];
 	InputState *oldInput = &input[1];
 
-	F32 deltaTime = 1.0f / 60.0f;
+	// NOTE(final): Measured time of the last frame, the game simulates in fixed steps on its own
+	F32 deltaTime = targetSecondsPerFrame;
 
 	LARGE_INTEGER flipWallClock = Win32GetWallClock();
 	LARGE_INTEGER lastCounter = Win32GetWallClock();
@@ -408,7 +423,8 @@ int WINAPI WinMain(HINSTANCE hInstance, HINSTANCE hPrevInstance, LPSTR pCmdLine,
 
 		// NOTE(final): Finalize Frame
 		LARGE_INTEGER endCounter = Win32GetWallClock();
-		FRAME_MARKER(Win32GetSecondsElapsed(lastCounter, endCounter));
+		deltaTime = Win32GetSecondsElapsed(lastCounter, endCounter);
+		FRAME_MARKER(deltaTime);
 		lastCounter = endCounter;
 
 		DEBUGFrameEnd();